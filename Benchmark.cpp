@@ -0,0 +1,142 @@
+// Benchmark.cpp - On-target micro-benchmarks for the render and driver hot paths
+
+#ifdef BENCHMARK
+
+#  include "Benchmark.h"
+
+#  include "Model.h"
+#  include "SSD1306.h"
+#  include "SensorDataHistory.h"
+#  include "SensorDataTrend.h"
+#  include "View.h"
+
+#  define BENCHMARK_ITERATIONS 100
+#  define BENCHMARK_SAMPLE_INTERVAL_MS 3000UL
+// Two days and a minute of samples, so every trend tier has closed buckets to chart.
+#  define BENCHMARK_SAMPLES ((2UL * 24 * 60 + 1) * 60000UL / BENCHMARK_SAMPLE_INTERVAL_MS)
+
+// The QingKe V2A core of the CH32V003 has no mcycle counter, so time is taken with micros()
+// over many iterations and converted to core cycles afterwards.
+
+Benchmark::Benchmark(Model& model, View& view, SSD1306& display) : model(model), view(view), display(display) {
+}
+
+void Benchmark::run() {
+  const uint16_t n = BENCHMARK_ITERATIONS;
+  SensorDataHistory& history = model.getTemperatureHistory();
+  uint32_t start, bytes;
+
+  finishFlush();
+  fillModel(BENCHMARK_SAMPLES);
+  Serial.println("name,iterations,ns_per_op,cycles_per_op,i2c_bytes_per_op");
+
+  int16_t minValue, maxValue;
+  start = micros();
+  for (uint16_t i = 0; i < n; i++) {
+    history.getMinMaxValue(history.getCount(), minValue, maxValue);
+  }
+  report("getMinMaxValue", n, micros() - start, 0);
+
+  display.clearDisplay();
+  start = micros();
+  for (uint16_t i = 0; i < n; i++) {
+    // Alternate shallow and steep lines across the chart area.
+    int16_t y = i % display.getHeight();
+    display.drawLine(0, y, display.getWidth() - 1, display.getHeight() - 1 - y);
+    display.drawLine(i % display.getWidth(), 0, display.getWidth() - 1 - i % display.getWidth(), display.getHeight() - 1);
+  }
+  report("drawLine", n * 2, micros() - start, 0);
+
+  display.clearDisplay();
+  display.setTextColor(SSD1306_WHITE, SSD1306_BLACK);
+  start = micros();
+  for (uint16_t i = 0; i < n; i++) {
+    display.setTextSize(1 + i % 3);
+    display.drawChar(0, 0, '0' + i % 10, SSD1306_WHITE);
+  }
+  report("drawChar", n, micros() - start, 0);
+
+  display.clearDisplay();
+  bytes = getBytesSent();
+  start = micros();
+  for (uint16_t i = 0; i < n; i++) {
+    display.drawPixel(i % display.getWidth(), 0, SSD1306_WHITE);
+    display.display();
+  }
+  report("display", n, micros() - start, getBytesSent() - bytes);
+
+  // render() only draws and starts the transfer; the flush is timed separately above. The model does
+  // not change between calls, so invalidate() keeps render() from skipping the frame.
+  uint32_t elapsed = 0;
+  bytes = getBytesSent();
+  for (uint8_t mode = 0; mode < View::VIEW_MODE_COUNT; mode++) {
+    view.setViewMode(static_cast<View::ViewMode>(mode));
+    for (uint16_t i = 0; i < n; i++) {
+      view.invalidate();
+      start = micros();
+      view.render();
+      elapsed += micros() - start;
+      finishFlush();
+    }
+  }
+  report("render", n * View::VIEW_MODE_COUNT, elapsed, getBytesSent() - bytes);
+
+  view.setViewMode(View::VIEW_MODE_CHART);
+  clearModel();
+}
+
+// Feeds a slow sine-like wave with some noise so that the charts have a realistic range. The
+// samples are stamped one sample interval apart rather than waited for.
+void Benchmark::fillModel(size_t count) {
+  Model::SensorData data = {};
+  data.channelCount = model.getChannelCount();
+  data.resolution = 12;
+  int16_t value = 2000;
+  int16_t slope = 7;
+  unsigned long now = millis();
+  for (size_t i = 0; i < count; i++) {
+    if (value > 2600 || value < 1800) {
+      slope = -slope;
+    }
+    value += slope + static_cast<int16_t>(i * 37 % 11) - 5;
+    for (uint8_t channel = 0; channel < data.channelCount; channel++) {
+      data.temperature[channel] = value + channel * 50;
+    }
+    model.update(data, now);
+    now += BENCHMARK_SAMPLE_INTERVAL_MS;
+  }
+}
+
+void Benchmark::clearModel() {
+  for (uint8_t channel = 0; channel < model.getChannelCount(); channel++) {
+    model.getTemperatureHistory(channel).begin();
+    model.getTemperatureTrend(channel).begin();
+  }
+}
+
+void Benchmark::finishFlush() {
+  while (display.update()) {
+  }
+}
+
+void Benchmark::report(const char* name, uint16_t iterations, uint32_t elapsedUs, uint32_t bytes) {
+  Serial.print(name);
+  Serial.print(",");
+  Serial.print(iterations);
+  Serial.print(",");
+  Serial.print(elapsedUs * 1000UL / iterations);
+  Serial.print(",");
+  Serial.print(elapsedUs * clockCyclesPerMicrosecond() / iterations);
+  Serial.print(",");
+  Serial.println(bytes / iterations);
+}
+
+uint32_t Benchmark::getBytesSent() const {
+#  ifdef SSD1306_STATISTICS
+  return display.getBytesSent();
+#  else
+  return 0;
+#  endif
+}
+
+#endif  // BENCHMARK
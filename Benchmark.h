@@ -0,0 +1,39 @@
+// Benchmark.h - On-target micro-benchmarks for the render and driver hot paths
+
+#pragma once
+
+#ifndef BENCHMARK_H
+#  define BENCHMARK_H
+
+#  include <Arduino.h>
+
+class Model;
+class SSD1306;
+class View;
+
+// Built only with -DBENCHMARK (see `make bench/ch32v003`). run() prints one CSV row per hot path
+// over Serial:
+//
+//   name,iterations,ns_per_op,cycles_per_op,i2c_bytes_per_op
+//
+// The model is filled with synthetic samples while it runs and cleared again afterwards.
+class Benchmark {
+ public:
+  Benchmark(Model& model, View& view, SSD1306& display);
+
+  void run();
+
+ private:
+  void fillModel(size_t count);
+  void clearModel();
+  void finishFlush();
+  void report(const char* name, uint16_t iterations, uint32_t elapsedUs, uint32_t bytes);
+
+  uint32_t getBytesSent() const;
+
+  Model& model;
+  View& view;
+  SSD1306& display;
+};
+
+#endif  // BENCHMARK_H
@@ -6,50 +6,151 @@
 #include "DS18B20.h"
 #include "Model.h"
 #include "OneWire.h"
+#include "Profiler.h"
 #include "SSD1306.h"
 #include "SensorDataHistory.h"
+#include "SensorDataTrend.h"
 #include "SensorManager.h"
 #include "View.h"
 
+#if defined(__riscv) && defined(CH32V003)
+#  include "ch32v00x.h"
+#endif
+
+#ifdef BENCHMARK
+#  include "Benchmark.h"
+#endif
+
 #define SERIAL_SPEED 115200
 #define BUTTON_PIN PD0
 #define DS18B20_PIN PC5
 #define DS18B20_TEMPERATURE_OFFSET -90
+#define DS18B20_RESOLUTION 12  // 9-12 bits; conversion takes 94/188/375/750 ms
 #define DISPLAY_WIDTH 128
 #define DISPLAY_HEIGHT 32
+#if defined(SSD1306_WIDTH) && (SSD1306_WIDTH != DISPLAY_WIDTH || SSD1306_HEIGHT != DISPLAY_HEIGHT)
+#  error "SSD1306_WIDTH/SSD1306_HEIGHT build flags do not match DISPLAY_WIDTH/DISPLAY_HEIGHT"
+#endif
 #define DISPLAY_BUFFER_SIZE (DISPLAY_WIDTH * DISPLAY_HEIGHT / 8)
+#define DISPLAY_USE_SHADOW_BUFFER 0  // 1: skip unchanged bytes on flush (costs another DISPLAY_BUFFER_SIZE bytes of RAM)
+#define DISPLAY_USE_HARDWARE_SCROLL 0  // 1: scroll the chart in controller RAM (needs a genuine SSD1306; some clones lack the command)
+#define DISPLAY_ROTATION 0  // 0/2: landscape; 1/3: portrait, mounted vertically (build with -DSSD1306_QUARTER_ROTATION)
 #define MEASUREMENT_INTERVAL_MS 3000
 #define HORIZONTAL_STEP 3
 #define HISTORY_BUFFER_SIZE ((DISPLAY_WIDTH + HORIZONTAL_STEP - 1) / HORIZONTAL_STEP + 1)
+#define TREND_BUFFER_SIZE 24
+#define BUTTON_POLL_INTERVAL_MS 10
+#define BUTTON_SETTLE_MS 1000  // keep polling this long after an edge so clicks and long presses resolve
 
 uint8_t displayBuffer[DISPLAY_BUFFER_SIZE];
+#if DISPLAY_USE_SHADOW_BUFFER
+uint8_t displayShadowBuffer[DISPLAY_BUFFER_SIZE];
+#endif
 int16_t temperatureHistoryBuffer[HISTORY_BUFFER_SIZE];
+uint16_t temperatureHistoryMinIndexBuffer[HISTORY_BUFFER_SIZE];
+uint16_t temperatureHistoryMaxIndexBuffer[HISTORY_BUFFER_SIZE];
+SensorDataTrend::Bucket temperatureTrendBuffer[SensorDataTrend::TIER_COUNT * TREND_BUFFER_SIZE];
 
 DigitalButton button(BUTTON_PIN, true);
+#if DISPLAY_USE_SHADOW_BUFFER
+SSD1306 display(DISPLAY_WIDTH, DISPLAY_HEIGHT, displayBuffer, &Wire, displayShadowBuffer);
+#else
 SSD1306 display(DISPLAY_WIDTH, DISPLAY_HEIGHT, displayBuffer);
+#endif
 OneWire oneWire(DS18B20_PIN, true);
-DS18B20 ds18b20(oneWire, DS18B20_TEMPERATURE_OFFSET);
+DS18B20 ds18b20(oneWire, DS18B20_TEMPERATURE_OFFSET, DS18B20_RESOLUTION);
 
-SensorDataHistory temperatureHistory(temperatureHistoryBuffer, HISTORY_BUFFER_SIZE);
-Model model(temperatureHistory);
+SensorDataHistory temperatureHistory(temperatureHistoryBuffer, HISTORY_BUFFER_SIZE, temperatureHistoryMinIndexBuffer, temperatureHistoryMaxIndexBuffer);
+SensorDataTrend temperatureTrend(temperatureTrendBuffer, TREND_BUFFER_SIZE);
+// For several probes on one bus, build with -DDS18B20_MAX_DEVICES=N and pass
+// arrays of N histories/trends with a channel count of N.
+Model model(&temperatureHistory, &temperatureTrend, 1);
 View view(model, display, HORIZONTAL_STEP);
 SensorManager sensorManager(ds18b20, MEASUREMENT_INTERVAL_MS);
 
+volatile bool buttonChanged = false;
+volatile unsigned long buttonChangeTime = 0;
+
+void onButtonChange() {
+  buttonChanged = true;
+  buttonChangeTime = millis();
+}
+
+// Sleeps until the next event is due: the sensor state machine's next step, the button debounce
+// window, or a pin change on BUTTON_PIN. A pending render or display transfer is never slept through.
+// In the PROFILE build, serial input also ends the wait.
+void waitForNextEvent(bool needRender) {
+  buttonChanged = false;
+  if (needRender || display.isBusy()) {
+    return;
+  }
+
+  unsigned long wait = sensorManager.getMillisUntilNextEvent();
+  unsigned long now = millis();
+  bool buttonActive = digitalRead(BUTTON_PIN) == LOW || now - buttonChangeTime < BUTTON_SETTLE_MS;
+  if (buttonActive && wait > BUTTON_POLL_INTERVAL_MS) {
+    wait = BUTTON_POLL_INTERVAL_MS;
+  }
+
+  while (!buttonChanged && millis() - now < wait) {
+#ifdef PROFILE
+    // Answer serial commands right away rather than at the next sensor event.
+    if (Serial.available()) {
+      break;
+    }
+#endif
+#if defined(__riscv) && defined(CH32V003)
+    // The SysTick interrupt behind millis() wakes the core every millisecond.
+    __WFI();
+#endif
+  }
+}
+
 void setup() {
   button.begin();
+  attachInterrupt(digitalPinToInterrupt(BUTTON_PIN), onButtonChange, CHANGE);
   oneWire.begin();
   sensorManager.begin();
   delay(100);
 
   model.begin();
   view.begin();
+  display.setHardwareScroll(DISPLAY_USE_HARDWARE_SCROLL);
+  view.setRotation(DISPLAY_ROTATION);
+
+#if defined(BENCHMARK) || defined(PROFILE)
+  Serial.begin(SERIAL_SPEED);
+#endif
+#ifdef BENCHMARK
+  Benchmark benchmark(model, view, display);
+  benchmark.run();
+#endif
 }
 
 void loop() {
   static bool needRender = true;
 
+#ifdef PROFILE
+  // Serial commands: 'p' prints the profile table and the last DS18B20 conversion time against
+  // the worst-case wait, 'r' clears the table.
+  if (Serial.available()) {
+    char command = Serial.read();
+    if (command == 'p') {
+      PROFILE_DUMP();
+      Serial.println("conversion,measured_ms,max_ms");
+      Serial.print("ds18b20,");
+      Serial.print(sensorManager.getSensorData().conversionTimeMs);
+      Serial.print(",");
+      Serial.println(ds18b20.getConversionTimeMs());
+    } else if (command == 'r') {
+      PROFILE_RESET();
+    }
+  }
+#endif
+
   button.update();
   sensorManager.update();
+  display.update();
 
   if (button.isLongPressed()) {
     // DEBUG_SERIAL_PRINTLN("Button 1 long pressed");
@@ -71,10 +172,9 @@ void loop() {
     needRender = true;
   }
 
-  if (needRender) {
-    view.render();
+  if (needRender && view.render()) {
     needRender = false;
   }
 
-  delay(10);
+  waitForNextEvent(needRender);
 }
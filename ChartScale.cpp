@@ -0,0 +1,24 @@
+// ChartScale.cpp - Value to chart row mapping without a division per value
+
+#include "ChartScale.h"
+
+ChartScale makeChartScale(int16_t maxValue, int16_t range, int16_t chartY, int16_t chartH) {
+  ChartScale scale = {maxValue, (uint16_t)range, chartY, chartH, 0};
+  if (range != 0) {
+    scale.reciprocal = ((uint32_t)(chartH - 1) << 16) / scale.range;
+  }
+  return scale;
+}
+
+int16_t scaleToChartY(const ChartScale& scale, int16_t value) {
+  if (scale.range == 0) {
+    return scale.chartY + scale.chartH / 2;
+  }
+  uint16_t offset = (uint16_t)(scale.maxValue - value);
+  uint32_t rows = (uint32_t)offset * (scale.chartH - 1);
+  uint16_t y = (uint16_t)(((uint32_t)offset * scale.reciprocal) >> 16);
+  if ((uint32_t)(y + 1) * scale.range <= rows) {
+    y++;
+  }
+  return scale.chartY + (int16_t)y;
+}
@@ -0,0 +1,25 @@
+// ChartScale.h - Value to chart row mapping without a division per value
+
+#pragma once
+
+#ifndef CHART_SCALE_H
+#  define CHART_SCALE_H
+
+#  include <Arduino.h>
+
+// Maps values to chart rows, chartY + (maxValue - value) * (chartH - 1) / range rounded down,
+// without a division per value (RV32EC has no divide instruction). The 16.16 reciprocal of range
+// rounds down, so the estimate is at most one row short and one check makes it exact.
+struct ChartScale {
+  int16_t maxValue;
+  uint16_t range;
+  int16_t chartY;
+  int16_t chartH;
+  uint32_t reciprocal;
+};
+
+// range is maxValue minus the smallest value charted; a zero range puts every value mid-chart.
+ChartScale makeChartScale(int16_t maxValue, int16_t range, int16_t chartY, int16_t chartH);
+int16_t scaleToChartY(const ChartScale& scale, int16_t value);
+
+#endif  // CHART_SCALE_H
@@ -3,36 +3,223 @@
 #include "DS18B20.h"
 
 #include "OneWire.h"
+#include "Profiler.h"
 #include "SensorManager.h"
 
-DS18B20::DS18B20(OneWire& wire, int16_t offset) : wire(wire), offset(offset) {
+#define DS18B20_SCRATCHPAD_SIZE 9
+#define DS18B20_TEMPERATURE_SIZE 2
+
+#define DS18B20_MIN_RESOLUTION 9
+#define DS18B20_MAX_RESOLUTION 12
+#define DS18B20_MAX_CONVERSION_TIME_MS 750
+
+// Factory defaults of the alarm registers, rewritten along with the configuration register.
+#define DS18B20_DEFAULT_TH 0x4B
+#define DS18B20_DEFAULT_TL 0x46
+
+static uint8_t clampResolution(uint8_t resolution) {
+  if (resolution < DS18B20_MIN_RESOLUTION) return DS18B20_MIN_RESOLUTION;
+  if (resolution > DS18B20_MAX_RESOLUTION) return DS18B20_MAX_RESOLUTION;
+  return resolution;
 }
 
+DS18B20::DS18B20(OneWire& wire, int16_t offset, uint8_t resolution, ReadMode readMode)
+    : wire(wire), offset(offset), resolution(clampResolution(resolution)), readMode(readMode), readState(READ_STATE_IDLE), readIndex(0), readSlots(0), readDevice(0), deviceCount(1), parasitePowered(true) {
+}
+
+#define DS18B20_FAMILY_CODE 0x28
+
 void DS18B20::begin(void) {
   wire.begin();
+  readState = READ_STATE_IDLE;
+  discoverDevices();
+  setResolution(resolution);
+
+  // READ POWER SUPPLY: parasite-powered devices pull the read slot low.
+  wire.reset();
+  wire.skip();
+  wire.write(0xB4, 0);
+  parasitePowered = (wire.read_bit() == 0);
 }
 
-void DS18B20::requestTemparature(void) {
+uint8_t DS18B20::discoverDevices(void) {
+  uint8_t found = 0;
+  uint8_t rom[8];
+
+  wire.resetSearch();
+  while (found < DS18B20_MAX_DEVICES && wire.search(rom)) {
+    if (rom[0] != DS18B20_FAMILY_CODE || OneWire::crc8(rom, 7) != rom[7]) {
+      continue;
+    }
+    memcpy(roms[found], rom, sizeof(rom));
+    found++;
+  }
+  wire.resetSearch();
+
+  // A single probe (or none found) keeps using SKIP ROM.
+  deviceCount = (found > 1) ? found : 1;
+  return found;
+}
+
+uint8_t DS18B20::getDeviceCount(void) const {
+  return deviceCount;
+}
+
+void DS18B20::setResolution(uint8_t resolution) {
+  this->resolution = clampResolution(resolution);
+
   wire.reset();
   wire.skip();
-  wire.write(0x44, 0);
+  wire.write(0x4E, 0);
+  wire.write(DS18B20_DEFAULT_TH, 0);
+  wire.write(DS18B20_DEFAULT_TL, 0);
+  wire.write(((this->resolution - DS18B20_MIN_RESOLUTION) << 5) | 0x1F, 0);
+}
+
+uint8_t DS18B20::getResolution(void) const {
+  return resolution;
 }
 
-bool DS18B20::readTemparature(int16_t& temperature) {
+unsigned long DS18B20::getConversionTimeMs(void) const {
+  // 750 ms at 12 bits, halved for each bit less (93.75 ms at 9 bits, rounded up).
+  uint8_t shift = DS18B20_MAX_RESOLUTION - resolution;
+  return (DS18B20_MAX_CONVERSION_TIME_MS + (1UL << shift) - 1) >> shift;
+}
+
+void DS18B20::requestTemparature(void) {
   wire.reset();
   wire.skip();
-  wire.write(0xBE, 0);
+  wire.write(0x44, 0);
+}
+
+bool DS18B20::isConversionComplete(void) {
+  // Converting devices hold read slots low.
+  return wire.read_bit() != 0;
+}
 
-  uint8_t data[9];
-  for (int i = 0; i < 9; i++) {
-    data[i] = wire.read();
+bool DS18B20::isParasitePowered(void) const {
+  return parasitePowered;
+}
+
+bool DS18B20::readTemparature(int16_t& temperature, uint8_t index) {
+  PROFILE_SCOPE(PROFILE_DS18B20_READ);
+
+  beginReadTemparature(index);
+
+  ReadStatus status;
+  while ((status = pollReadTemparature(temperature)) == READ_BUSY) {
+  }
+  return status == READ_DONE;
+}
+
+void DS18B20::beginReadTemparature(uint8_t index) {
+  readDevice = index;
+  readState = wire.beginReset() ? READ_STATE_RESET : READ_STATE_IDLE;
+  readIndex = 0;
+  readSlots = 0;
+}
+
+DS18B20::ReadStatus DS18B20::pollReadTemparature(int16_t& temperature) {
+  PROFILE_SCOPE(PROFILE_DS18B20_POLL);
+
+  switch (readState) {
+    case READ_STATE_IDLE:
+      // No presence pulse
+      return READ_FAILED;
+
+    case READ_STATE_RESET:
+      if (!wire.isReady()) {
+        return READ_BUSY;
+      }
+      if (deviceCount > 1) {
+        if (readDevice >= deviceCount) {
+          readState = READ_STATE_IDLE;
+          return READ_FAILED;
+        }
+        // MATCH ROM, then the ROM code one byte per call.
+        wire.write(0x55);
+        readSlots += 8;
+        readState = READ_STATE_MATCH_ROM;
+      } else {
+        wire.skip();
+        readSlots += 8;
+        readState = READ_STATE_COMMAND;
+      }
+      return READ_BUSY;
+
+    case READ_STATE_MATCH_ROM:
+      wire.write(roms[readDevice][readIndex++]);
+      readSlots += 8;
+      if (readIndex == 8) {
+        readIndex = 0;
+        readState = READ_STATE_COMMAND;
+      }
+      return READ_BUSY;
+
+    case READ_STATE_COMMAND:
+      wire.write(0xBE, 0);
+      readSlots += 8;
+      readState = READ_STATE_DATA;
+      return READ_BUSY;
+
+    case READ_STATE_DATA: {
+      scratchpad[readIndex++] = wire.read();
+      readSlots += 8;
+
+      uint8_t length = (readMode == READ_MODE_FAST) ? DS18B20_TEMPERATURE_SIZE : DS18B20_SCRATCHPAD_SIZE;
+      if (readIndex < length) {
+        return READ_BUSY;
+      }
+      if (readMode == READ_MODE_FAST) {
+        readState = READ_STATE_ABORT;
+        return READ_BUSY;
+      }
+      readState = READ_STATE_IDLE;
+
+      if (!verifyScratchpad()) {
+        return READ_FAILED;
+      }
+      return convertScratchpad(temperature) ? READ_DONE : READ_FAILED;
+    }
+
+    case READ_STATE_ABORT:
+      // Reset to abort the rest of the scratchpad transfer, on a call of its own.
+      wire.beginReset();
+      readState = READ_STATE_IDLE;
+      return convertScratchpad(temperature) ? READ_DONE : READ_FAILED;
+  }
+  return READ_FAILED;
+}
+
+void DS18B20::setReadMode(ReadMode mode) {
+  readMode = mode;
+}
+
+DS18B20::ReadMode DS18B20::getReadMode(void) const {
+  return readMode;
+}
+
+uint8_t DS18B20::getLastReadSlots(void) const {
+  return readSlots;
+}
+
+bool DS18B20::verifyScratchpad(void) const {
+  if (OneWire::crc8(scratchpad, DS18B20_SCRATCHPAD_SIZE - 1) != scratchpad[DS18B20_SCRATCHPAD_SIZE - 1]) {
+    return false;
   }
+  // An all-zero scratchpad passes the CRC; the configuration register has fixed bits.
+  return (scratchpad[4] & 0x9F) == 0x1F;
+}
 
-  if (data[0] == 0xFF && data[1] == 0xFF) {
+bool DS18B20::convertScratchpad(int16_t& temperature) const {
+  if (scratchpad[0] == 0xFF && scratchpad[1] == 0xFF) {
     return false;
   }
 
-  int16_t raw = (data[1] << 8) | data[0];
+  int16_t raw = (scratchpad[1] << 8) | scratchpad[0];
+  // Low bits are undefined below 12-bit resolution. Clearing them snaps the reading to the sensor
+  // step before the offset is added, so the calibration offset is kept exactly.
+  raw &= ~((1 << (DS18B20_MAX_RESOLUTION - resolution)) - 1);
   int32_t temparature = (static_cast<int32_t>(raw) * 100) / 16;
   temperature = static_cast<int16_t>(temparature) + offset;
   return true;
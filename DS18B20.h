@@ -7,19 +7,80 @@
 
 #  include <Arduino.h>
 
+// Number of probes a DS18B20 bus can address. With more than one device found,
+// each read uses MATCH ROM; otherwise SKIP ROM is used as for a single probe.
+#  ifndef DS18B20_MAX_DEVICES
+#    define DS18B20_MAX_DEVICES 1
+#  endif
+
 class OneWire;
 
 class DS18B20 {
  public:
-  DS18B20(OneWire& wire, int16_t offset = 0);
+  enum ReadStatus {
+    READ_BUSY,
+    READ_DONE,
+    READ_FAILED,
+  };
+
+  enum ReadMode {
+    READ_MODE_FAST,      // temperature bytes only, then reset
+    READ_MODE_VERIFIED,  // full scratchpad with CRC8 check
+  };
+
+  // resolution: 9 to 12 bits (0.5 to 0.0625 degC); lower resolutions convert faster.
+  DS18B20(OneWire& wire, int16_t offset = 0, uint8_t resolution = 12, ReadMode readMode = READ_MODE_VERIFIED);
 
   void begin(void);
+  uint8_t discoverDevices(void);
+  uint8_t getDeviceCount(void) const;
+  void setResolution(uint8_t resolution);
+  uint8_t getResolution(void) const;
+  unsigned long getConversionTimeMs(void) const;
+  // Starts a conversion on every device on the bus at once.
   void requestTemparature(void);
-  bool readTemparature(int16_t& temperature);
+  // Right after requestTemparature(): true once every device has finished converting.
+  // Only meaningful when no device is parasite powered.
+  bool isConversionComplete(void);
+  bool isParasitePowered(void) const;
+  bool readTemparature(int16_t& temperature, uint8_t index = 0);
+
+  // Non-blocking read: call pollReadTemparature() until it stops returning READ_BUSY.
+  // Each call clocks at most one byte or one reset pulse, including the MATCH ROM code on a
+  // multi-drop bus, so the main loop keeps running between them.
+  void beginReadTemparature(uint8_t index = 0);
+  ReadStatus pollReadTemparature(int16_t& temperature);
+
+  void setReadMode(ReadMode mode);
+  ReadMode getReadMode(void) const;
+  // Read/write bit slots used by the last scratchpad read (reset pulses not included).
+  uint8_t getLastReadSlots(void) const;
 
  private:
+  enum ReadState {
+    READ_STATE_IDLE,
+    READ_STATE_RESET,
+    READ_STATE_MATCH_ROM,
+    READ_STATE_COMMAND,
+    READ_STATE_DATA,
+    READ_STATE_ABORT,
+  };
+
+  bool verifyScratchpad(void) const;
+  bool convertScratchpad(int16_t& temperature) const;
+
   OneWire& wire;
   int16_t offset;
+  uint8_t resolution;
+  ReadMode readMode;
+  ReadState readState;
+  uint8_t readIndex;
+  uint8_t readSlots;
+  uint8_t readDevice;
+  uint8_t scratchpad[9];
+  uint8_t deviceCount;
+  bool parasitePowered;
+  uint8_t roms[DS18B20_MAX_DEVICES][8];
 };
 
 #endif  // DS18B20_H
@@ -3,21 +3,49 @@
 #include "Model.h"
 
 #include "SensorDataHistory.h"
+#include "SensorDataTrend.h"
 
-Model::Model(SensorDataHistory& temperatureHistory) : temperatureHistory(temperatureHistory) {
+Model::Model(SensorDataHistory* temperatureHistories, SensorDataTrend* temperatureTrends, uint8_t channelCount)
+    : temperatureHistories(temperatureHistories), temperatureTrends(temperatureTrends), channelCount(channelCount), temperatureResolution(12), generation(0) {
 }
 
 void Model::begin() {
 }
 
 void Model::update(const SensorData& data) {
-  temperatureHistory.prepend(data.temperature);
+  update(data, millis());
 }
 
-int16_t Model::getTemperature() const {
-  return temperatureHistory.getValue(0);
+void Model::update(const SensorData& data, unsigned long now) {
+  for (uint8_t channel = 0; channel < channelCount; channel++) {
+    int16_t temperature = (channel < data.channelCount) ? data.temperature[channel] : INVALID_TEMPERATURE_VALUE;
+    temperatureHistories[channel].prepend(temperature);
+    temperatureTrends[channel].add(temperature, now);
+  }
+  temperatureResolution = data.resolution;
+  generation++;
 }
 
-SensorDataHistory& Model::getTemperatureHistory() const {
-  return temperatureHistory;
+uint16_t Model::getGeneration() const {
+  return generation;
+}
+
+uint8_t Model::getChannelCount() const {
+  return channelCount;
+}
+
+int16_t Model::getTemperature(uint8_t channel) const {
+  return temperatureHistories[channel].getValue(0);
+}
+
+uint8_t Model::getTemperatureResolution() const {
+  return temperatureResolution;
+}
+
+SensorDataHistory& Model::getTemperatureHistory(uint8_t channel) const {
+  return temperatureHistories[channel];
+}
+
+SensorDataTrend& Model::getTemperatureTrend(uint8_t channel) const {
+  return temperatureTrends[channel];
 }
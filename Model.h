@@ -10,21 +10,34 @@
 #  include "SensorManager.h"
 
 class SensorDataHistory;
+class SensorDataTrend;
 
 class Model {
  public:
   using SensorData = SensorManager::SensorData;
 
-  Model(SensorDataHistory& temperatureHistory);
+  // temperatureHistories/temperatureTrends hold one entry per sensor channel.
+  Model(SensorDataHistory* temperatureHistories, SensorDataTrend* temperatureTrends, uint8_t channelCount = 1);
 
   void begin();
   void update(const SensorData& data);
+  // Same, with the sample time given instead of read from millis().
+  void update(const SensorData& data, unsigned long now);
 
-  int16_t getTemperature() const;
-  SensorDataHistory& getTemperatureHistory() const;
+  // Incremented by every update(), so a view can tell that nothing arrived since it last looked.
+  uint16_t getGeneration() const;
+  uint8_t getChannelCount() const;
+  int16_t getTemperature(uint8_t channel = 0) const;
+  uint8_t getTemperatureResolution() const;
+  SensorDataHistory& getTemperatureHistory(uint8_t channel = 0) const;
+  SensorDataTrend& getTemperatureTrend(uint8_t channel = 0) const;
 
  private:
-  SensorDataHistory& temperatureHistory;
+  SensorDataHistory* temperatureHistories;
+  SensorDataTrend* temperatureTrends;
+  uint8_t channelCount;
+  uint8_t temperatureResolution;
+  uint16_t generation;
 };
 
 #endif  // MODEL_H
@@ -2,32 +2,9 @@
 
 #include "OneWire.h"
 
-#if defined(__AVR__)
-#  define OW_DISABLE_IRQ() noInterrupts()
-#  define OW_ENABLE_IRQ() interrupts()
-static inline void delay_us(uint16_t us) {
-  delayMicroseconds(us);
-}
-
-static inline void ow_output_low(uint8_t pin) {
-  digitalWrite(pin, LOW);
-  pinMode(pin, OUTPUT);
-}
-
-static inline void ow_input(uint8_t pin, bool useInputPullup) {
-  if (useInputPullup) {
-    digitalWrite(pin, HIGH);
-    pinMode(pin, OUTPUT);
-    pinMode(pin, INPUT_PULLUP);
-  } else {
-    pinMode(pin, INPUT);
-  }
-}
+#include "Profiler.h"
 
-static inline uint8_t ow_read(uint8_t pin) {
-  return digitalRead(pin) ? 1 : 0;
-}
-#elif defined(__riscv) && defined(CH32V003)
+#if defined(__riscv) && defined(CH32V003)
 #  include "ch32v00x.h"
 
 extern uint32_t SystemCoreClock;
@@ -83,10 +60,38 @@ static inline uint8_t ow_read(uint8_t pin) {
   return (gpio->INDR & (1 << pinNum)) ? 1 : 0;
 }
 #else
-#  error "Not supported"
+// Portable implementation on top of the Arduino pin API (AVR and other cores).
+#  define OW_DISABLE_IRQ() noInterrupts()
+#  define OW_ENABLE_IRQ() interrupts()
+static inline void delay_us(uint16_t us) {
+  delayMicroseconds(us);
+}
+
+static inline void ow_output_low(uint8_t pin) {
+  digitalWrite(pin, LOW);
+  pinMode(pin, OUTPUT);
+}
+
+static inline void ow_input(uint8_t pin, bool useInputPullup) {
+  if (useInputPullup) {
+    digitalWrite(pin, HIGH);
+    pinMode(pin, OUTPUT);
+    pinMode(pin, INPUT_PULLUP);
+  } else {
+    pinMode(pin, INPUT);
+  }
+}
+
+static inline uint8_t ow_read(uint8_t pin) {
+  return digitalRead(pin) ? 1 : 0;
+}
 #endif
 
-OneWire::OneWire(uint8_t pin, bool useInputPullup) : pin(pin), useInputPullup(useInputPullup) {
+// Time from the presence sample to the end of the reset sequence.
+#define OW_RESET_RECOVERY_US 410
+
+OneWire::OneWire(uint8_t pin, bool useInputPullup) : pin(pin), useInputPullup(useInputPullup), resetTime(0), recovering(false) {
+  resetSearch();
 }
 
 void OneWire::begin(void) {
@@ -94,6 +99,19 @@ void OneWire::begin(void) {
 }
 
 uint8_t OneWire::reset(void) {
+  PROFILE_SCOPE(PROFILE_ONEWIRE_RESET);
+
+  uint8_t r = beginReset();
+  if (recovering) {
+    delay_us(OW_RESET_RECOVERY_US);
+    recovering = false;
+  }
+  return r;
+}
+
+// Issues the reset pulse and samples the presence pulse, but leaves the
+// recovery time to the caller: poll isReady() before the next slot.
+uint8_t OneWire::beginReset(void) {
   uint8_t r;
   uint8_t retries = 125;
 
@@ -114,16 +132,93 @@ uint8_t OneWire::reset(void) {
   ow_input(pin, useInputPullup);
   delay_us(70);
   r = (ow_read(pin) == 0) ? 1 : 0;
-  delay_us(410);
+  resetTime = micros();
+  recovering = true;
 
   OW_ENABLE_IRQ();
   return r;
 }
 
+bool OneWire::isReady(void) const {
+  return !recovering || (micros() - resetTime >= OW_RESET_RECOVERY_US);
+}
+
 void OneWire::skip(void) {
   write(0xCC);
 }
 
+void OneWire::select(const uint8_t rom[8]) {
+  write(0x55);
+  for (uint8_t i = 0; i < 8; i++) {
+    write(rom[i]);
+  }
+}
+
+void OneWire::resetSearch(void) {
+  memset(searchRom, 0, sizeof(searchRom));
+  lastDiscrepancy = 0;
+  lastDeviceFound = false;
+}
+
+// Maxim application note 187 ROM search. Returns the next device ROM on the bus,
+// or false once every device has been reported. The caller should check the ROM CRC.
+bool OneWire::search(uint8_t rom[8]) {
+  if (lastDeviceFound || !reset()) {
+    resetSearch();
+    return false;
+  }
+
+  write(0xF0);
+
+  uint8_t lastZero = 0;
+  for (uint8_t bitNumber = 1; bitNumber <= 64; bitNumber++) {
+    uint8_t byteIndex = (bitNumber - 1) / 8;
+    uint8_t bitMask = 1 << ((bitNumber - 1) & 7);
+
+    uint8_t idBit = read_bit();
+    uint8_t complementBit = read_bit();
+    if (idBit && complementBit) {
+      // No device answered
+      resetSearch();
+      return false;
+    }
+
+    uint8_t direction;
+    if (idBit != complementBit) {
+      direction = idBit;
+    } else {
+      // Discrepancy: devices with both values are still taking part.
+      if (bitNumber < lastDiscrepancy) {
+        direction = (searchRom[byteIndex] & bitMask) ? 1 : 0;
+      } else {
+        direction = (bitNumber == lastDiscrepancy) ? 1 : 0;
+      }
+      if (direction == 0) {
+        lastZero = bitNumber;
+      }
+    }
+
+    if (direction) {
+      searchRom[byteIndex] |= bitMask;
+    } else {
+      searchRom[byteIndex] &= ~bitMask;
+    }
+    write_bit(direction);
+  }
+
+  lastDiscrepancy = lastZero;
+  if (lastDiscrepancy == 0) {
+    lastDeviceFound = true;
+  }
+
+  if (searchRom[0] == 0) {
+    resetSearch();
+    return false;
+  }
+  memcpy(rom, searchRom, sizeof(searchRom));
+  return true;
+}
+
 void OneWire::write_bit(uint8_t v) {
   OW_DISABLE_IRQ();
   if (v & 1) {
@@ -172,3 +267,20 @@ uint8_t OneWire::read(void) {
   }
   return r;
 }
+
+// Dallas/Maxim CRC8 (x^8 + x^5 + x^4 + 1), one nibble table lookup per half byte.
+static const uint8_t crc8LowNibbleTable[] PROGMEM = {
+  0x00, 0x5E, 0xBC, 0xE2, 0x61, 0x3F, 0xDD, 0x83, 0xC2, 0x9C, 0x7E, 0x20, 0xA3, 0xFD, 0x1F, 0x41,
+};
+static const uint8_t crc8HighNibbleTable[] PROGMEM = {
+  0x00, 0x9D, 0x23, 0xBE, 0x46, 0xDB, 0x65, 0xF8, 0x8C, 0x11, 0xAF, 0x32, 0xCA, 0x57, 0xE9, 0x74,
+};
+
+uint8_t OneWire::crc8(const uint8_t* data, uint8_t len) {
+  uint8_t crc = 0;
+  while (len--) {
+    crc ^= *data++;
+    crc = pgm_read_byte(&crc8LowNibbleTable[crc & 0x0F]) ^ pgm_read_byte(&crc8HighNibbleTable[crc >> 4]);
+  }
+  return crc;
+}
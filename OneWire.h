@@ -13,15 +13,29 @@ class OneWire {
 
   void begin(void);
   uint8_t reset(void);
+  uint8_t beginReset(void);
+  bool isReady(void) const;
   void skip(void);
+  void select(const uint8_t rom[8]);
+  void resetSearch(void);
+  bool search(uint8_t rom[8]);
   void write(uint8_t v, uint8_t power = 0);
   uint8_t read(void);
   void write_bit(uint8_t v);
   uint8_t read_bit(void);
 
+  static uint8_t crc8(const uint8_t* data, uint8_t len);
+
  private:
   uint8_t pin;
   bool useInputPullup;
+  unsigned long resetTime;
+  bool recovering;
+
+  // ROM search state
+  uint8_t searchRom[8];
+  uint8_t lastDiscrepancy;
+  bool lastDeviceFound;
 };
 
 #endif  // ONEWIRE_H
@@ -0,0 +1,61 @@
+// Profiler.cpp - Compile-time removable hot-path profiler
+
+#include "Profiler.h"
+
+#ifdef PROFILE
+
+// The CH32V003 core has no cycle counter CSR; cycles are derived from micros(), so the resolution
+// is one microsecond (48 cycles at 48 MHz).
+
+static const char* const PROFILE_POINT_NAMES[PROFILE_POINT_COUNT] = {
+  "SensorManager::update",
+  "View::render",
+  "SSD1306::display",
+  "SSD1306::update",
+  "OneWire::reset",
+  "DS18B20::readTemparature",
+  "DS18B20::pollReadTemparature",
+};
+
+Profiler::Entry Profiler::entries[PROFILE_POINT_COUNT];
+
+void Profiler::record(ProfilePoint point, unsigned long elapsedUs) {
+  Entry& entry = entries[point];
+  uint16_t us = (elapsedUs > UINT16_MAX) ? UINT16_MAX : static_cast<uint16_t>(elapsedUs);
+  if (entry.count == 0 || us < entry.minUs) {
+    entry.minUs = us;
+  }
+  if (us > entry.maxUs) {
+    entry.maxUs = us;
+  }
+  entry.totalUs += elapsedUs;
+  entry.count++;
+}
+
+void Profiler::reset() {
+  for (uint8_t i = 0; i < PROFILE_POINT_COUNT; i++) {
+    entries[i].count = 0;
+    entries[i].totalUs = 0;
+    entries[i].minUs = 0;
+    entries[i].maxUs = 0;
+  }
+}
+
+void Profiler::dump() {
+  const uint32_t cyclesPerUs = clockCyclesPerMicrosecond();
+  Serial.println("name,count,min_cycles,max_cycles,avg_cycles");
+  for (uint8_t i = 0; i < PROFILE_POINT_COUNT; i++) {
+    const Entry& entry = entries[i];
+    Serial.print(PROFILE_POINT_NAMES[i]);
+    Serial.print(",");
+    Serial.print(entry.count);
+    Serial.print(",");
+    Serial.print(entry.minUs * cyclesPerUs);
+    Serial.print(",");
+    Serial.print(entry.maxUs * cyclesPerUs);
+    Serial.print(",");
+    Serial.println(entry.count ? entry.totalUs / entry.count * cyclesPerUs : 0);
+  }
+}
+
+#endif  // PROFILE
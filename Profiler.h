@@ -0,0 +1,73 @@
+// Profiler.h - Compile-time removable hot-path profiler
+
+#pragma once
+
+#ifndef PROFILER_H
+#  define PROFILER_H
+
+#  include <Arduino.h>
+
+enum ProfilePoint {
+  PROFILE_SENSOR_UPDATE = 0,
+  PROFILE_VIEW_RENDER,
+  PROFILE_DISPLAY_FLUSH,
+  PROFILE_DISPLAY_UPDATE,
+  PROFILE_ONEWIRE_RESET,
+  PROFILE_DS18B20_READ,
+  PROFILE_DS18B20_POLL,
+  PROFILE_POINT_COUNT,
+};
+
+// Build with -DPROFILE to collect min/max/avg core cycles per point. Without it the macros expand
+// to nothing and the profiler takes no RAM or flash.
+#  ifdef PROFILE
+#    define PROFILE_SCOPE(point) Profiler::Scope profileScope(point)
+#    define PROFILE_DUMP() Profiler::dump()
+#    define PROFILE_RESET() Profiler::reset()
+#  else
+#    define PROFILE_SCOPE(point) \
+      do {                       \
+      } while (0)
+#    define PROFILE_DUMP() \
+      do {                 \
+      } while (0)
+#    define PROFILE_RESET() \
+      do {                  \
+      } while (0)
+#  endif
+
+#  ifdef PROFILE
+class Profiler {
+ public:
+  // Times the enclosing block.
+  class Scope {
+   public:
+    explicit Scope(ProfilePoint point) : point(point), start(micros()) {
+    }
+    ~Scope() {
+      Profiler::record(point, micros() - start);
+    }
+
+   private:
+    ProfilePoint point;
+    unsigned long start;
+  };
+
+  static void record(ProfilePoint point, unsigned long elapsedUs);
+  static void reset();
+  // Prints "name,count,min_cycles,max_cycles,avg_cycles" per point over Serial.
+  static void dump();
+
+ private:
+  struct Entry {
+    uint32_t count;
+    uint32_t totalUs;
+    uint16_t minUs;
+    uint16_t maxUs;
+  };
+
+  static Entry entries[PROFILE_POINT_COUNT];
+};
+#  endif
+
+#endif  // PROFILER_H
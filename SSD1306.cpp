@@ -2,24 +2,79 @@
 
 #include "SSD1306.h"
 
-SSD1306::SSD1306(uint8_t width, uint8_t height, uint8_t* buffer, TwoWire* wire)
+#include "Profiler.h"
+
+#if defined(SSD1306_FIXED_GEOMETRY) && !defined(SSD1306_QUARTER_ROTATION)
+constexpr uint8_t SSD1306::_width;
+constexpr uint8_t SSD1306::_height;
+#endif
+
+SSD1306::SSD1306(uint8_t width, uint8_t height, uint8_t* buffer, TwoWire* wire, uint8_t* shadowBuffer)
     : _wire(wire),
       _address(0x3C),
+#ifndef SSD1306_FIXED_GEOMETRY
       _width(width),
       _height(height),
+#elif defined(SSD1306_QUARTER_ROTATION)
+      _width(SSD1306_WIDTH),
+      _height(SSD1306_HEIGHT),
+      _geometryValid(width == SSD1306_WIDTH && height == SSD1306_HEIGHT),
+#else
+      _geometryValid(width == SSD1306_WIDTH && height == SSD1306_HEIGHT),
+#endif
       _buffer(buffer),
+      _shadowBuffer(shadowBuffer),
+      _shadowValid(false),
+      _flushing(false),
+      _pageActive(false),
+      _flushPage(0),
+      _flushCol(0),
+      _flushEndCol(0),
+      _runPos(1),
+      _runEnd(0),
+      _hardwareScroll(false),
+      _scrollActive(false),
+      _scrollPending(0),
+      _scrollStartPage(0),
+      _scrollEndPage(0),
+      _scrollStartCol(0),
+      _scrollEndCol(0),
+      _scrollTime(0),
       _cursorX(0),
       _cursorY(0),
       _textColor(SSD1306_WHITE),
       _textBgColor(SSD1306_BLACK),
       _textSize(1),
-      _colOffset(0) {
+      _colOffset(0),
+      _rotation(0) {
+#ifdef SSD1306_STATISTICS
+  _bytesSent = 0;
+#endif
+#ifdef SSD1306_QUARTER_ROTATION
+  _blockIndex = 0xFF;
+#endif
+  for (uint8_t page = 0; page < SSD1306_MAX_PAGES; page++) {
+    _dirtyMin[page] = 0xFF;
+    _dirtyMax[page] = 0;
+    _inkMin[page] = 0xFF;
+    _inkMax[page] = 0;
+  }
 }
 
 bool SSD1306::begin(uint8_t address) {
+#ifdef SSD1306_FIXED_GEOMETRY
+  if (!_geometryValid) return false;
+#endif
   _address = address;
   _wire->begin();
 
+#ifdef SSD1306_QUARTER_ROTATION
+  if (_rotation & 1) {
+    clearDisplay();
+    transposeCanvas();
+  }
+#endif
+
   if (_width == 96 && _height == 32) {
     _colOffset = 16;
   } else {
@@ -49,32 +104,108 @@ bool SSD1306::begin(uint8_t address) {
 
   sendCommandList(initCmds, sizeof(initCmds));
 
+  _rotation = 0;
+  _scrollActive = false;
+  _scrollPending = 0;
   clearDisplay();
+  markAllDirty();
+  _shadowValid = false;
 
   return true;
 }
 
 void SSD1306::clearDisplay() {
+  // Only columns that may have held lit pixels change when clearing.
+  for (uint8_t page = 0; page < _height / 8; page++) {
+    if (_inkMin[page] < _dirtyMin[page]) _dirtyMin[page] = _inkMin[page];
+    if (_inkMax[page] > _dirtyMax[page]) _dirtyMax[page] = _inkMax[page];
+    _inkMin[page] = 0xFF;
+    _inkMax[page] = 0;
+  }
   memset(_buffer, 0, (uint16_t)_width * (_height / 8));
 }
 
 void SSD1306::display() {
-  sendBuffer();
+  PROFILE_SCOPE(PROFILE_DISPLAY_FLUSH);
+
+  displayAsync();
+  while (update()) {
+  }
+}
+
+void SSD1306::displayAsync() {
+  if (_flushing) return;
+  _flushing = true;
+  _pageActive = false;
+  _flushPage = 0;
+  _runPos = 1;
+  _runEnd = 0;
+#ifdef SSD1306_QUARTER_ROTATION
+  if (_rotation & 1) {
+    transposeDirtyRanges();
+  }
+#endif
+}
+
+bool SSD1306::isBusy() const {
+  return _flushing;
+}
+
+bool SSD1306::update() {
+  if (!_flushing) return false;
+  PROFILE_SCOPE(PROFILE_DISPLAY_UPDATE);
+
+  if (_scrollActive && pumpContentScroll()) {
+    return true;
+  }
+
+  if (_runPos <= _runEnd) {
+    sendBurst();
+    return true;
+  }
+
+  if (startNextRun()) {
+    return true;
+  }
+
+  _flushing = false;
+  _shadowValid = (_shadowBuffer != nullptr);
+  return false;
 }
 
 void SSD1306::setRotation(uint8_t rotation) {
-  switch (rotation & 3) {
-    case 0:
-    case 1:
-      sendCommand(0xA1);
-      sendCommand(0xC8);
-      break;
-    case 2:
-    case 3:
-      sendCommand(0xA0);
-      sendCommand(0xC0);
-      break;
+#ifdef SSD1306_QUARTER_ROTATION
+  rotation &= 3;
+#else
+  rotation &= 2;
+#endif
+  if (rotation == _rotation) return;
+
+#ifdef SSD1306_QUARTER_ROTATION
+  // The flush transposes the drawing area and the remap and scan commands mirror the result, so
+  // a quarter turn is the transpose mirrored along one axis.
+  if ((rotation ^ _rotation) & 1) {
+    clearDisplay();
+    transposeCanvas();
   }
+#endif
+
+  // Segment remap only applies to data written afterwards, so resend everything.
+  _rotation = rotation;
+  markAllDirty();
+  _shadowValid = false;
+
+  static const uint8_t rotationCmds[4][2] = {
+    {0xA1, 0xC8},
+    {0xA0, 0xC8},
+    {0xA0, 0xC0},
+    {0xA1, 0xC0},
+  };
+  sendCommandList(rotationCmds[rotation], 2);
+}
+
+uint8_t SSD1306::getRotation() const {
+  return _rotation;
 }
 
 uint8_t SSD1306::getWidth() const {
@@ -85,9 +216,40 @@ uint8_t SSD1306::getHeight() const {
   return _height;
 }
 
+uint8_t SSD1306::panelWidth() const {
+#ifdef SSD1306_QUARTER_ROTATION
+  if (_rotation & 1) return _height;
+#endif
+  return _width;
+}
+
+uint8_t SSD1306::panelHeight() const {
+#ifdef SSD1306_QUARTER_ROTATION
+  if (_rotation & 1) return _width;
+#endif
+  return _height;
+}
+
+#ifdef SSD1306_STATISTICS
+uint32_t SSD1306::getBytesSent() const {
+  return _bytesSent;
+}
+#endif
+
+// Adds columns x0..x1 of pages firstPage..lastPage, all on screen, to the dirty and ink ranges.
+void SSD1306::markDirtyPages(uint8_t x0, uint8_t x1, uint8_t firstPage, uint8_t lastPage) {
+  for (uint8_t page = firstPage; page <= lastPage; page++) {
+    if (x0 < _dirtyMin[page]) _dirtyMin[page] = x0;
+    if (x1 > _dirtyMax[page]) _dirtyMax[page] = x1;
+    if (x0 < _inkMin[page]) _inkMin[page] = x0;
+    if (x1 > _inkMax[page]) _inkMax[page] = x1;
+  }
+}
+
 void SSD1306::drawPixel(int16_t x, int16_t y, uint8_t color) {
   if (x < 0 || x >= _width || y < 0 || y >= _height) return;
 
+  markDirty(x, y, x, y);
   uint16_t idx = x + (y / 8) * _width;
   uint8_t bit = 1 << (y & 7);
   if (color == SSD1306_WHITE) {
@@ -97,6 +259,30 @@ void SSD1306::drawPixel(int16_t x, int16_t y, uint8_t color) {
   }
 }
 
+// Steps 0..len from p in direction s that land on 0..limit - 1, as first..last. Returns false if none do.
+static bool clipSteps(int16_t p, int8_t s, int16_t len, int16_t limit, int16_t& first, int16_t& last) {
+  int16_t toNear = (s > 0) ? -p : p - (limit - 1);
+  int16_t toFar = (s > 0) ? limit - 1 - p : p;
+  first = (toNear > 0) ? toNear : 0;
+  last = (toFar < len) ? toFar : len;
+  return first <= last;
+}
+
+// n / d by repeated subtraction, leaving n % d in n. The quotients in drawLine() are bounded by the
+// line length, so this is never slower than the per-pixel loop it replaces and needs no libgcc
+// division on RV32EC.
+static int16_t divideSteps(int32_t& n, int32_t d) {
+  int16_t q = 0;
+  while (n >= d) {
+    n -= d;
+    q++;
+  }
+  return q;
+}
+
+// Bresenham from (x0, y0) puts pixel k of the major axis (length major) floor((2 * minor * k +
+// major - 1) / (2 * major)) steps along the minor axis. Both ends are clipped with that once, then
+// shallow lines write one pixel per column and steep lines one masked span per column.
 void SSD1306::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t color) {
   int16_t dx = abs(x1 - x0);
   int16_t dy = abs(y1 - y0);
@@ -113,38 +299,116 @@ void SSD1306::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t c
     return;
   }
 
-  if (dx == dy) {
-    drawDiagLine(x0, y0, dx, sx, sy, color);
-    return;
-  }
+  // Steps along each axis that stay on screen.
+  int16_t xFirst, xLast, yFirst, yLast;
+  if (!clipSteps(x0, sx, dx, _width, xFirst, xLast) || !clipSteps(y0, sy, dy, _height, yFirst, yLast)) return;
 
-  int16_t err = dx - dy;
+  int32_t twoDx = (int32_t)dx * 2;
+  int32_t twoDy = (int32_t)dy * 2;
+  int32_t n;
 
-  while (true) {
-    if (x0 >= 0 && x0 < _width && y0 >= 0 && y0 < _height) {
-      uint16_t idx = x0 + (y0 / 8) * _width;
-      uint8_t bit = 1 << (y0 & 7);
-      if (color == SSD1306_WHITE) {
-        _buffer[idx] |= bit;
-      } else {
-        _buffer[idx] &= ~bit;
+  if (dx >= dy) {
+    // Shallow: narrow the column steps to those whose row is on screen.
+    if (yFirst > 0) {
+      n = twoDx * yFirst - dx + twoDy;
+      int16_t k = divideSteps(n, twoDy);
+      if (k > xFirst) xFirst = k;
+    }
+    if (yLast < dy) {
+      n = twoDx * yLast + dx;
+      int16_t k = divideSteps(n, twoDy);
+      if (k < xLast) xLast = k;
+    }
+    if (xFirst > xLast) return;
+
+    n = twoDy * xFirst + dx - 1;
+    int16_t y = y0 + sy * divideSteps(n, twoDx);
+    int16_t x = x0 + sx * xFirst;
+    int16_t yStart = y;
+    uint8_t* p = &_buffer[x + (y / 8) * _width];
+    uint8_t bit = 1 << (y & 7);
+    uint8_t ink = (color == SSD1306_WHITE) ? 0xFF : 0x00;
+    int16_t pageStep = (sy > 0) ? _width : -_width;
+    uint8_t wrapBit = (sy > 0) ? 0x01 : 0x80;
+
+    for (int16_t k = xLast - xFirst;; k--) {
+      *p = (*p & ~bit) | (bit & ink);
+      if (k == 0) break;
+      p += sx;
+      n += twoDy;
+      if (n >= twoDx) {
+        n -= twoDx;
+        y += sy;
+        bit = (sy > 0) ? (uint8_t)((bit << 1) | (bit >> 7)) : (uint8_t)((bit >> 1) | (bit << 7));
+        if (bit == wrapBit) p += pageStep;
       }
     }
 
-    if (x0 == x1 && y0 == y1) {
-      break;
-    }
+    int16_t xEnd = x0 + sx * xLast;
+    markDirtyPages(x < xEnd ? x : xEnd, x < xEnd ? xEnd : x, (yStart < y ? yStart : y) / 8, (yStart < y ? y : yStart) / 8);
+    return;
+  }
 
-    int16_t e2 = err * 2;
-    if (e2 > -dy) {
-      err -= dy;
-      x0 += sx;
+  // Steep: narrow the row steps to those whose column is on screen.
+  if (xFirst > 0) {
+    n = twoDy * xFirst - dy + twoDx;
+    int16_t k = divideSteps(n, twoDx);
+    if (k > yFirst) yFirst = k;
+  }
+  if (xLast < dx) {
+    n = twoDy * xLast + dy;
+    int16_t k = divideSteps(n, twoDx);
+    if (k < yLast) yLast = k;
+  }
+  if (yFirst > yLast) return;
+
+  // Column of the first row, and in next the first row of the following column with its
+  // remainder kept as next * 2dx - (2dy * column + dy + 1), stepped by slope = 2dy / 2dx per column.
+  n = twoDx * yFirst + dy - 1;
+  int16_t column = divideSteps(n, twoDy);
+  n = twoDy * column + dy + twoDx;
+  int16_t next = divideSteps(n, twoDx);
+  int32_t remainder = twoDx - 1 - n;
+  n = twoDy;
+  int16_t slope = divideSteps(n, twoDx);
+  int32_t slopeRemainder = n;
+
+  int16_t xStart = x0 + sx * column;
+  uint8_t* p = &_buffer[xStart];
+  uint8_t ink = (color == SSD1306_WHITE) ? 0xFF : 0x00;
+  int16_t row = yFirst;
+  while (true) {
+    int16_t last = (next - 1 < yLast) ? next - 1 : yLast;
+    int16_t top = (sy > 0) ? y0 + row : y0 - last;
+    int16_t bottom = (sy > 0) ? y0 + last : y0 - row;
+
+    // One masked write per page the column's run touches.
+    uint8_t* q = p + (top >> 3) * _width;
+    uint8_t mask = 0xFF << (top & 7);
+    for (int16_t page = top >> 3; page < bottom >> 3; page++) {
+      *q = (*q & ~mask) | (mask & ink);
+      mask = 0xFF;
+      q += _width;
     }
-    if (e2 < dx) {
-      err += dx;
-      y0 += sy;
+    mask &= 0xFF >> (7 - (bottom & 7));
+    *q = (*q & ~mask) | (mask & ink);
+    if (last == yLast) break;
+
+    row = last + 1;
+    column++;
+    p += sx;
+    next += slope;
+    remainder -= slopeRemainder;
+    if (remainder < 0) {
+      remainder += twoDx;
+      next++;
     }
   }
+
+  int16_t xEnd = x0 + sx * column;
+  int16_t yA = y0 + sy * yFirst;
+  int16_t yB = y0 + sy * yLast;
+  markDirtyPages(xStart < xEnd ? xStart : xEnd, xStart < xEnd ? xEnd : xStart, (yA < yB ? yA : yB) / 8, (yA < yB ? yB : yA) / 8);
 }
 
 void SSD1306::drawVLine(int16_t x, int16_t y, int16_t h, uint8_t color) {
@@ -152,20 +416,152 @@ void SSD1306::drawVLine(int16_t x, int16_t y, int16_t h, uint8_t color) {
     y += h + 1;
     h = -h;
   }
-  if (x < 0 || x >= _width) return;
+  if (h == 0 || x < 0 || x >= _width) return;
   int16_t y1 = y + h - 1;
   if (y1 < 0 && y < 0) return;
   if (y >= _height && y1 >= _height) return;
   if (y < 0) y = 0;
   if (y1 >= _height) y1 = _height - 1;
-  for (int16_t yy = y; yy <= y1; yy++) {
-    uint16_t idx = x + (yy / 8) * _width;
-    uint8_t bit = 1 << (yy & 7);
+  markDirty(x, y, x, y1);
+  drawColumnSpan(x, y, y1, color);
+}
+
+void SSD1306::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t color) {
+  int16_t x1 = x + w - 1;
+  int16_t y1 = y + h - 1;
+  if (x < 0) x = 0;
+  if (y < 0) y = 0;
+  if (x1 >= _width) x1 = _width - 1;
+  if (y1 >= _height) y1 = _height - 1;
+  if (x > x1 || y > y1) return;
+
+  for (uint8_t page = y / 8; page <= y1 / 8; page++) {
+    int16_t start = x;
+    int16_t end = x1;
+    if (color != SSD1306_WHITE) {
+      // Clearing only changes columns that may hold lit pixels.
+      if (_inkMin[page] > start) start = _inkMin[page];
+      if (_inkMax[page] < end) end = _inkMax[page];
+      if (start > end) continue;
+    }
+
+    int16_t top = (page * 8 > y) ? page * 8 : y;
+    int16_t bottom = (page * 8 + 7 < y1) ? page * 8 + 7 : y1;
+    uint8_t mask = (0xFF << (top & 7)) & (0xFF >> (7 - (bottom & 7)));
+    markDirty(start, top, end, bottom);
+
+    uint8_t* p = &_buffer[page * _width + start];
+    for (int16_t xx = start; xx <= end; xx++, p++) {
+      if (color == SSD1306_WHITE) {
+        *p |= mask;
+      } else {
+        *p &= ~mask;
+      }
+    }
+  }
+}
+
+bool SSD1306::scrollRegionLeft(int16_t x, int16_t y, int16_t w, int16_t h, int16_t dx) {
+  if ((y & 7) != 0 || (h & 7) != 0) return false;
+  int16_t x1 = x + w - 1;
+  if (x < 0) x = 0;
+  if (y < 0) y = 0;
+  if (x1 >= _width) x1 = _width - 1;
+  int16_t endPage = (y + h) / 8;
+  if (endPage > _height / 8) endPage = _height / 8;
+  if (x > x1 || y / 8 >= endPage || dx <= 0) return true;
+
+  uint8_t span = x1 - x + 1;
+  uint8_t kept = (dx < span) ? span - dx : 0;
+
+  // The controller can only follow if its RAM matches the buffer: nothing queued or in flight for
+  // the region, and the normal orientation (how segment remap affects the scroll is unspecified).
+  bool hardware = _hardwareScroll && !_flushing && !_scrollActive && _rotation == 0 && kept > 0;
+  for (uint8_t page = y / 8; hardware && page < endPage; page++) {
+    if (_dirtyMin[page] <= _dirtyMax[page]) hardware = false;
+  }
+
+  if (hardware) {
+    _scrollActive = true;
+    _scrollPending = dx;
+    _scrollStartPage = y / 8;
+    _scrollEndPage = endPage - 1;
+    _scrollStartCol = x;
+    _scrollEndCol = x1;
+    _scrollTime = millis() - SSD1306_CONTENT_SCROLL_INTERVAL_MS;
+
+    // Each command moves the region one column left and wraps the first column to the right end.
+    if (_shadowBuffer != nullptr) {
+      for (uint8_t page = y / 8; page < endPage; page++) {
+        uint8_t* row = &_shadowBuffer[page * _width + x];
+        for (int16_t i = 0; i < dx; i++) {
+          uint8_t first = row[0];
+          memmove(row, row + 1, span - 1);
+          row[span - 1] = first;
+        }
+      }
+    }
+  }
+
+  for (uint8_t page = y / 8; page < endPage; page++) {
+    // Blank pages stay blank, and lit pixels only move left from the page's ink range.
+    if (_inkMin[page] > _inkMax[page] || _inkMax[page] < x || _inkMin[page] > x1) continue;
+
+    uint8_t* row = &_buffer[page * _width + x];
+    memmove(row, row + (span - kept), kept);
+    memset(row + kept, 0, span - kept);
+
+    // Columns from the shifted ink start up to the old ink end change; the ink range moves with them.
+    int16_t inkMin = _inkMin[page];
+    int16_t inkMax = _inkMax[page];
+    int16_t start = (inkMin - dx > x) ? inkMin - dx : x;
+    int16_t end = (inkMax < x1) ? inkMax : x1;
+    // With hardware scroll the controller moves the columns itself; only the wrapped ones at the
+    // right end are stale.
+    int16_t dirtyStart = hardware ? x1 - dx + 1 : start;
+    int16_t dirtyEnd = hardware ? x1 : end;
+    if (dirtyStart < _dirtyMin[page]) _dirtyMin[page] = dirtyStart;
+    if (dirtyEnd > _dirtyMax[page]) _dirtyMax[page] = dirtyEnd;
+
+    if (inkMin >= x) inkMin = start;
+    if (inkMax <= x1) inkMax -= dx;
+    if (inkMax < inkMin) {
+      _inkMin[page] = 0xFF;
+      _inkMax[page] = 0;
+    } else {
+      _inkMin[page] = inkMin;
+      _inkMax[page] = inkMax;
+    }
+  }
+  return true;
+}
+
+void SSD1306::setHardwareScroll(bool enabled) {
+  _hardwareScroll = enabled;
+}
+
+// Sets or clears rows y0..y1 (y0 <= y1) of column x with one masked write per page. No bounds checks.
+void SSD1306::drawColumnSpan(int16_t x, int16_t y0, int16_t y1, uint8_t color) {
+  uint8_t* p = &_buffer[x + (y0 / 8) * _width];
+  uint8_t page = y0 / 8;
+  uint8_t endPage = y1 / 8;
+  uint8_t mask = 0xFF << (y0 & 7);
+
+  while (true) {
+    if (page == endPage) {
+      mask &= 0xFF >> (7 - (y1 & 7));
+    }
     if (color == SSD1306_WHITE) {
-      _buffer[idx] |= bit;
+      *p |= mask;
     } else {
-      _buffer[idx] &= ~bit;
+      *p &= ~mask;
     }
+    if (page == endPage) {
+      break;
+    }
+    mask = 0xFF;
+    p += _width;
+    page++;
   }
 }
 
@@ -180,6 +576,7 @@ void SSD1306::drawHLine(int16_t x, int16_t y, int16_t w, uint8_t color) {
   if (x >= _width && x1 >= _width) return;
   if (x < 0) x = 0;
   if (x1 >= _width) x1 = _width - 1;
+  markDirty(x, y, x1, y);
   uint16_t idx = x + (y / 8) * _width;
   uint8_t bit = 1 << (y & 7);
   if (color == SSD1306_WHITE) {
@@ -194,20 +591,41 @@ void SSD1306::drawHLine(int16_t x, int16_t y, int16_t w, uint8_t color) {
   }
 }
 
+// Font column nibbles with every bit repeated 2 or 3 times, for text sizes 2 and 3.
+// clang-format off
+static const uint8_t FONT_EXPAND_2X[16] PROGMEM = {
+  0x00, 0x03, 0x0C, 0x0F, 0x30, 0x33, 0x3C, 0x3F, 0xC0, 0xC3, 0xCC, 0xCF, 0xF0, 0xF3, 0xFC, 0xFF,
+};
+static const uint16_t FONT_EXPAND_3X[16] PROGMEM = {
+  0x000, 0x007, 0x038, 0x03F, 0x1C0, 0x1C7, 0x1F8, 0x1FF, 0xE00, 0xE07, 0xE38, 0xE3F, 0xFC0, 0xFC7, 0xFF8, 0xFFF,
+};
+// clang-format on
+
+// Scales a 7-row font column to 7 * size rows (size 1-3), bit 0 at the top.
+static uint32_t expandFontColumn(uint8_t line, uint8_t size) {
+  uint8_t low = line & 0x0F;
+  uint8_t high = (line >> 4) & 0x07;
+  switch (size) {
+    case 2:
+      return pgm_read_byte(&FONT_EXPAND_2X[low]) | ((uint32_t)pgm_read_byte(&FONT_EXPAND_2X[high]) << 8);
+    case 3:
+      return pgm_read_word(&FONT_EXPAND_3X[low]) | ((uint32_t)pgm_read_word(&FONT_EXPAND_3X[high]) << 12);
+    default:
+      return line & 0x7F;
+  }
+}
+
 void SSD1306::drawChar(int16_t x, int16_t y, char c, uint8_t color) {
   int8_t idx = Font5x7_GetIndex(c);
   if (idx < 0) {
     idx = 0;
   }
 
-  const uint8_t* fontData = &Font5x7[idx * FONT5X7_WIDTH];
-  uint8_t bg = _textBgColor;
-  uint8_t fontBuffer[FONT5X7_WIDTH];
-  memcpy_P(fontBuffer, fontData, FONT5X7_WIDTH);
-
   if (x < 0 || x + FONT5X7_WIDTH * _textSize > _width) return;
   if (y < 0 || y >= _height) return;
 
+  const uint8_t* fontData = &Font5x7[idx * FONT5X7_WIDTH];
+  bool opaque = (_textBgColor != color);
   uint16_t totalHeight = FONT5X7_HEIGHT * _textSize;
   uint8_t startPage = y / 8;
   uint8_t endPage = (y + totalHeight - 1) / 8;
@@ -216,47 +634,58 @@ void SSD1306::drawChar(int16_t x, int16_t y, char c, uint8_t color) {
     endPage = _height / 8 - 1;
   }
 
+  markDirty(x, startPage * 8, x + FONT5X7_WIDTH * _textSize - 1, endPage * 8 + 7);
+
+  // Up to size 3 a scaled column (21 rows) shifted to its row within the page fits in 32 bits,
+  // so each page byte comes straight out of it.
+  bool expand = (_textSize <= 3);
+  uint8_t shift = y & 7;
+  uint32_t cellBits = expand ? (((uint32_t)1 << totalHeight) - 1) << shift : 0;
+  uint8_t* column = &_buffer[startPage * _width + x];
+
   for (uint8_t i = 0; i < FONT5X7_WIDTH; i++) {
-    uint8_t line = fontBuffer[i];
+    uint8_t line = pgm_read_byte(&fontData[i]);
+    uint32_t lineBits = expand ? expandFontColumn(line, _textSize) << shift : 0;
+    uint32_t cell = cellBits;
+    uint8_t* p = column;
 
     for (uint8_t page = startPage; page <= endPage; page++) {
       uint8_t pageBits = 0;
       uint8_t bgBits = 0;
 
-      for (uint8_t b = 0; b < 8; b++) {
-        int16_t screenY = page * 8 + b;
-        if (screenY < y || screenY >= y + (int16_t)totalHeight) {
-          continue;
-        }
-        int16_t fontY = screenY - y;
-        uint8_t srcBit = fontY / _textSize;
-        if (srcBit < FONT5X7_HEIGHT && (line & (1 << srcBit))) {
-          pageBits |= (1 << b);
-        } else if (srcBit < FONT5X7_HEIGHT) {
-          bgBits |= (1 << b);
+      if (expand) {
+        pageBits = (uint8_t)lineBits;
+        bgBits = (uint8_t)cell & ~pageBits;
+        lineBits >>= 8;
+        cell >>= 8;
+      } else {
+        for (uint8_t b = 0; b < 8; b++) {
+          int16_t fontY = page * 8 + b - y;
+          if (fontY < 0 || fontY >= (int16_t)totalHeight) {
+            continue;
+          }
+          if (line & (1 << (fontY / _textSize))) {
+            pageBits |= (1 << b);
+          } else {
+            bgBits |= (1 << b);
+          }
         }
       }
 
-      uint16_t bufBase = page * _width + x + i * _textSize;
+      // Opaque text owns the whole byte: white writes the glyph bits, black the background bits.
+      uint8_t value = (color == SSD1306_WHITE) ? pageBits : bgBits;
       for (uint8_t col = 0; col < _textSize; col++) {
-        uint16_t bufIdx = bufBase + col;
-        if (bufIdx >= (uint16_t)_width * (_height / 8)) continue;
-
-        if (bg != color) {
-          if (color == SSD1306_WHITE) {
-            _buffer[bufIdx] = pageBits;
-          } else {
-            _buffer[bufIdx] = bgBits;
-          }
+        if (opaque) {
+          p[col] = value;
+        } else if (color == SSD1306_WHITE) {
+          p[col] |= pageBits;
         } else {
-          if (color == SSD1306_WHITE) {
-            _buffer[bufIdx] |= pageBits;
-          } else {
-            _buffer[bufIdx] &= ~pageBits;
-          }
+          p[col] &= ~pageBits;
         }
       }
+      p += _width;
     }
+    column += _textSize;
   }
 }
 
@@ -316,13 +745,6 @@ void SSD1306::getTextBounds(const char* str, int16_t x, int16_t y, int16_t* x1,
   *h = FONT5X7_HEIGHT * _textSize;
 }
 
-void SSD1306::sendCommand(uint8_t cmd) {
-  _wire->beginTransmission(_address);
-  _wire->write(0x00);
-  _wire->write(cmd);
-  _wire->endTransmission();
-}
-
 void SSD1306::sendCommandList(const uint8_t* cmds, uint8_t count) {
   _wire->beginTransmission(_address);
   _wire->write(0x00);
@@ -330,42 +752,262 @@ void SSD1306::sendCommandList(const uint8_t* cmds, uint8_t count) {
     _wire->write(cmds[i]);
   }
   _wire->endTransmission();
+#ifdef SSD1306_STATISTICS
+  _bytesSent += count + 1;
+#endif
 }
 
-void SSD1306::sendBuffer() {
-  sendCommand(0x21);
-  sendCommand(_colOffset);
-  sendCommand(_colOffset + _width - 1);
+// Finds the next run of bytes to send and opens its address window.
+// Returns false when every dirty page has been sent.
+bool SSD1306::startNextRun() {
+  while (_flushPage < panelHeight() / 8) {
+    uint8_t page = _flushPage;
+
+    if (!_pageActive) {
+      if (_dirtyMin[page] > _dirtyMax[page]) {
+        _flushPage++;
+        continue;
+      }
+      _flushCol = _dirtyMin[page];
+      _flushEndCol = _dirtyMax[page];
+      _dirtyMin[page] = 0xFF;
+      _dirtyMax[page] = 0;
+      _pageActive = true;
+#ifdef SSD1306_QUARTER_ROTATION
+      _blockIndex = 0xFF;
+#endif
+
+      if (_shadowBuffer == nullptr || !_shadowValid) {
+        sendWindow(page, _flushCol, _flushEndCol);
+        _flushCol = _flushEndCol + 1;
+        return true;
+      }
+    }
+
+    if (_shadowBuffer != nullptr && _shadowValid) {
+      uint16_t base = (uint16_t)page * panelWidth();
+      uint8_t col = findChangedColumn(base, _flushCol, _flushEndCol);
+      if (col <= _flushEndCol) {
+        uint8_t runEnd = findUnchangedColumn(base, col, _flushEndCol);
+        uint8_t next = findChangedColumn(base, runEnd, _flushEndCol);
+        while (next <= _flushEndCol && next - runEnd < SSD1306_DIFF_MERGE_GAP) {
+          runEnd = findUnchangedColumn(base, next, _flushEndCol);
+          next = findChangedColumn(base, runEnd, _flushEndCol);
+        }
+        sendWindow(page, col, runEnd - 1);
+        _flushCol = next;
+        return true;
+      }
+    }
+
+    _pageActive = false;
+    _flushPage++;
+  }
+  return false;
+}
+
+// Sends the queued content scroll commands, each after the previous one has been applied.
+// Returns true while the scroll still holds back the data transfer.
+bool SSD1306::pumpContentScroll() {
+  if (millis() - _scrollTime < SSD1306_CONTENT_SCROLL_INTERVAL_MS) {
+    return true;
+  }
+  if (_scrollPending == 0) {
+    _scrollActive = false;
+    return false;
+  }
+
+  const uint8_t scrollCmds[] = {
+    0x2D, 0x00, _scrollStartPage, 0x01, _scrollEndPage, (uint8_t)(_colOffset + _scrollStartCol), (uint8_t)(_colOffset + _scrollEndCol),
+  };
+  sendCommandList(scrollCmds, sizeof(scrollCmds));
+  _scrollPending--;
+  _scrollTime = millis();
+  return true;
+}
 
-  sendCommand(0x22);
-  sendCommand(0);
-  sendCommand((_height / 8) - 1);
+void SSD1306::sendWindow(uint8_t page, uint8_t startCol, uint8_t endCol) {
+  const uint8_t windowCmds[] = {
+    0x21, (uint8_t)(_colOffset + startCol), (uint8_t)(_colOffset + endCol), 0x22, page, page,
+  };
+  sendCommandList(windowCmds, sizeof(windowCmds));
+  _runPos = startCol;
+  _runEnd = endCol;
+}
 
-  uint16_t totalBytes = (uint16_t)_width * (_height / 8);
+void SSD1306::sendBurst() {
+  uint16_t i = (uint16_t)_flushPage * panelWidth() + _runPos;
+  uint8_t remaining = _runEnd - _runPos + 1;
+  uint8_t chunk = (remaining > SSD1306_I2C_BURST_SIZE) ? SSD1306_I2C_BURST_SIZE : remaining;
 
-  for (uint16_t i = 0; i < totalBytes; i += 16) {
-    _wire->beginTransmission(_address);
-    _wire->write(0x40);
-    uint8_t chunk = (totalBytes - i > 16) ? 16 : (totalBytes - i);
+  _wire->beginTransmission(_address);
+  _wire->write(0x40);
+#ifdef SSD1306_QUARTER_ROTATION
+  if (_rotation & 1) {
+    for (uint8_t j = 0; j < chunk; j++) {
+      uint8_t value = transposedByte(_runPos + j);
+      _wire->write(value);
+      if (_shadowBuffer != nullptr) {
+        _shadowBuffer[i + j] = value;
+      }
+    }
+  } else
+#endif
+  {
     for (uint8_t j = 0; j < chunk; j++) {
       _wire->write(_buffer[i + j]);
     }
-    _wire->endTransmission();
+    if (_shadowBuffer != nullptr) {
+      memcpy(&_shadowBuffer[i], &_buffer[i], chunk);
+    }
+  }
+  _wire->endTransmission();
+#ifdef SSD1306_STATISTICS
+  _bytesSent += chunk + 1;
+#endif
+
+  if (chunk == remaining) {
+    _runPos = 1;
+    _runEnd = 0;
+  } else {
+    _runPos += chunk;
   }
 }
 
-void SSD1306::drawDiagLine(int16_t x, int16_t y, int16_t len, int8_t xdir, int8_t ydir, uint8_t color) {
-  for (int16_t i = 0; i <= len; i++) {
-    if (x >= 0 && x < _width && y >= 0 && y < _height) {
-      uint16_t idx = x + (y / 8) * _width;
-      uint8_t bit = 1 << (y & 7);
-      if (color == SSD1306_WHITE) {
-        _buffer[idx] |= bit;
-      } else {
-        _buffer[idx] &= ~bit;
-      }
+// Returns the first column in [col, endCol] whose byte differs from the shadow, or endCol + 1.
+uint8_t SSD1306::findChangedColumn(uint16_t base, uint8_t col, uint8_t endCol) {
+#ifdef SSD1306_QUARTER_ROTATION
+  if (_rotation & 1) {
+    while (col <= endCol && transposedByte(col) == _shadowBuffer[base + col]) {
+      col++;
+    }
+    return col;
+  }
+#endif
+  uint16_t i = base + col;
+  uint16_t end = base + endCol + 1;
+
+  // Compare a word at a time while both frames agree.
+  while (end - i >= 4) {
+    uint32_t a, b;
+    memcpy(&a, &_buffer[i], 4);
+    memcpy(&b, &_shadowBuffer[i], 4);
+    if (a != b) break;
+    i += 4;
+  }
+  while (i < end && _buffer[i] == _shadowBuffer[i]) {
+    i++;
+  }
+  return i - base;
+}
+
+// Returns the first column in [col, endCol] whose byte matches the shadow, or endCol + 1.
+uint8_t SSD1306::findUnchangedColumn(uint16_t base, uint8_t col, uint8_t endCol) {
+#ifdef SSD1306_QUARTER_ROTATION
+  if (_rotation & 1) {
+    while (col <= endCol && transposedByte(col) != _shadowBuffer[base + col]) {
+      col++;
     }
-    x += xdir;
-    y += ydir;
+    return col;
+  }
+#endif
+  uint16_t i = base + col;
+  uint16_t end = base + endCol + 1;
+  while (i < end && _buffer[i] != _shadowBuffer[i]) {
+    i++;
+  }
+  return i - base;
+}
+
+void SSD1306::markDirty(int16_t x0, int16_t y0, int16_t x1, int16_t y1) {
+  if (x1 < 0 || y1 < 0 || x0 >= _width || y0 >= _height) return;
+  if (x0 < 0) x0 = 0;
+  if (y0 < 0) y0 = 0;
+  if (x1 >= _width) x1 = _width - 1;
+  if (y1 >= _height) y1 = _height - 1;
+  markDirtyPages(x0, x1, y0 / 8, y1 / 8);
+}
+
+void SSD1306::markAllDirty() {
+  for (uint8_t page = 0; page < _height / 8; page++) {
+    _dirtyMin[page] = 0;
+    _dirtyMax[page] = _width - 1;
+  }
+}
+
+#ifdef SSD1306_QUARTER_ROTATION
+// Transposes an 8x8 bit matrix: bit j of in[i] becomes bit i of out[j]. Swaps 1-bit, 2-bit and
+// then 4-bit blocks on two 32-bit halves instead of moving 64 single bits.
+static void transpose8x8(const uint8_t* in, uint8_t* out) {
+  uint32_t x = ((uint32_t)in[7] << 24) | ((uint32_t)in[6] << 16) | ((uint32_t)in[5] << 8) | in[4];
+  uint32_t y = ((uint32_t)in[3] << 24) | ((uint32_t)in[2] << 16) | ((uint32_t)in[1] << 8) | in[0];
+  uint32_t t;
+
+  t = (x ^ (x >> 7)) & 0x00AA00AA;
+  x = x ^ t ^ (t << 7);
+  t = (y ^ (y >> 7)) & 0x00AA00AA;
+  y = y ^ t ^ (t << 7);
+
+  t = (x ^ (x >> 14)) & 0x0000CCCC;
+  x = x ^ t ^ (t << 14);
+  t = (y ^ (y >> 14)) & 0x0000CCCC;
+  y = y ^ t ^ (t << 14);
+
+  t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+  y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+  x = t;
+
+  out[0] = (uint8_t)y;
+  out[1] = (uint8_t)(y >> 8);
+  out[2] = (uint8_t)(y >> 16);
+  out[3] = (uint8_t)(y >> 24);
+  out[4] = (uint8_t)x;
+  out[5] = (uint8_t)(x >> 8);
+  out[6] = (uint8_t)(x >> 16);
+  out[7] = (uint8_t)(x >> 24);
+}
+
+void SSD1306::transposeCanvas() {
+  uint8_t width = _width;
+  _width = _height;
+  _height = width;
+}
+
+// Turns the dirty ranges of the drawing area (column ranges on its pages) into column ranges on the
+// panel's pages: drawing page q covers panel columns 8q..8q+7, and its columns c0..c1 the panel
+// pages c0/8..c1/8.
+void SSD1306::transposeDirtyRanges() {
+  uint8_t dirtyMin[SSD1306_MAX_PAGES];
+  uint8_t dirtyMax[SSD1306_MAX_PAGES];
+  uint8_t panelPages = _width / 8;
+
+  for (uint8_t page = 0; page < panelPages; page++) {
+    dirtyMin[page] = 0xFF;
+    dirtyMax[page] = 0;
+  }
+  for (uint8_t block = 0; block < _height / 8; block++) {
+    if (_dirtyMin[block] > _dirtyMax[block]) continue;
+    for (uint8_t page = _dirtyMin[block] / 8; page <= _dirtyMax[block] / 8; page++) {
+      if (block * 8 < dirtyMin[page]) dirtyMin[page] = block * 8;
+      dirtyMax[page] = block * 8 + 7;
+    }
+    _dirtyMin[block] = 0xFF;
+    _dirtyMax[block] = 0;
+  }
+  for (uint8_t page = 0; page < panelPages; page++) {
+    _dirtyMin[page] = dirtyMin[page];
+    _dirtyMax[page] = dirtyMax[page];
+  }
+}
+
+// Returns the panel byte at column col of the page being flushed, transposing the 8x8 block that
+// holds it (drawing columns 8 * page.. on drawing page col / 8) unless it is the last one used.
+uint8_t SSD1306::transposedByte(uint8_t col) {
+  uint8_t block = col >> 3;
+  if (block != _blockIndex) {
+    transpose8x8(&_buffer[(uint16_t)block * _width + _flushPage * 8], _block);
+    _blockIndex = block;
   }
+  return _block[col & 7];
 }
+#endif
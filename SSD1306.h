@@ -13,15 +13,72 @@
 #  define SSD1306_BLACK 0
 #  define SSD1306_WHITE 1
 
+// Build with -DSSD1306_WIDTH=... -DSSD1306_HEIGHT=... to fix the panel geometry at compile time.
+// Buffer offsets and bounds checks then fold into constants, and begin() drops the init branches
+// for other panels. The constructor's width and height must match; begin() fails otherwise, and
+// nothing may be drawn, as the buffer was sized for the other geometry.
+//
+// Build with -DSSD1306_QUARTER_ROTATION to allow setRotation(1) and setRotation(3). The drawing area
+// is then transposed (e.g. 32x128 on a 128x32 panel) and turned back page by page when flushing;
+// page bookkeeping grows to cover the longer side.
+#  if defined(SSD1306_WIDTH) && defined(SSD1306_HEIGHT)
+#    define SSD1306_FIXED_GEOMETRY
+#    if defined(SSD1306_QUARTER_ROTATION) && SSD1306_WIDTH > SSD1306_HEIGHT
+#      define SSD1306_MAX_PAGES (SSD1306_WIDTH / 8)
+#    else
+#      define SSD1306_MAX_PAGES (SSD1306_HEIGHT / 8)
+#    endif
+#  elif defined(SSD1306_QUARTER_ROTATION)
+#    define SSD1306_MAX_PAGES 16
+#  else
+#    define SSD1306_MAX_PAGES 8
+#  endif
+
+// Data bytes per I2C transaction; the control byte takes one more slot of the Wire buffer.
+#  ifndef SSD1306_I2C_BURST_SIZE
+#    if defined(I2C_BUFFER_LENGTH)
+#      define SSD1306_I2C_BURST_SIZE (I2C_BUFFER_LENGTH - 1)
+#    elif defined(WIRE_BUFFER_SIZE)
+#      define SSD1306_I2C_BURST_SIZE (WIRE_BUFFER_SIZE - 1)
+#    elif defined(BUFFER_LENGTH)
+#      define SSD1306_I2C_BURST_SIZE (BUFFER_LENGTH - 1)
+#    else
+#      define SSD1306_I2C_BURST_SIZE 16
+#    endif
+#  endif
+
+// Minimum spacing of content scroll commands; the controller needs two frames (about 6 ms each
+// for a 32-row panel at the default clock) to apply one.
+#  ifndef SSD1306_CONTENT_SCROLL_INTERVAL_MS
+#    define SSD1306_CONTENT_SCROLL_INTERVAL_MS 12
+#  endif
+
+// Unchanged bytes shorter than this between two changed runs are resent rather than
+// opening a new address window.
+#  define SSD1306_DIFF_MERGE_GAP 8
+
 class SSD1306 {
  public:
-  SSD1306(uint8_t width, uint8_t height, uint8_t* buffer, TwoWire* wire = &Wire);
+  // shadowBuffer (same size as buffer) is optional; with it, display() only sends bytes that differ
+  // from the last transmitted frame.
+  //
+  // display() blocks until the frame is sent. displayAsync() only starts the transfer; call update()
+  // from loop() to send it one I2C transaction at a time, and do not render while isBusy().
+  SSD1306(uint8_t width, uint8_t height, uint8_t* buffer, TwoWire* wire = &Wire, uint8_t* shadowBuffer = nullptr);
 
   bool begin(uint8_t address = 0x3C);
   void clearDisplay();
   void display();
+  void displayAsync();
+  bool isBusy() const;
+  bool update();
+  // 0 and 2 are upright and upside down; 1 and 3 turn by 90 and 270 degrees clockwise and need
+  // SSD1306_QUARTER_ROTATION (otherwise they act as 0 and 2). Commands are only sent on a change;
+  // a quarter turn clears the buffer. Do not call while isBusy().
   void setRotation(uint8_t rotation);
+  uint8_t getRotation() const;
 
+  // Size of the drawing area, swapped for quarter turns.
   uint8_t getWidth() const;
   uint8_t getHeight() const;
 
@@ -29,6 +86,14 @@ class SSD1306 {
   void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t color = SSD1306_WHITE);
   void drawVLine(int16_t x, int16_t y, int16_t h, uint8_t color = SSD1306_WHITE);
   void drawHLine(int16_t x, int16_t y, int16_t w, uint8_t color = SSD1306_WHITE);
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t color);
+  // Moves a page-aligned region (y and h multiples of 8) left by dx columns and clears the columns
+  // exposed on its right. Returns false, leaving the buffer untouched, if the region is not page-aligned.
+  bool scrollRegionLeft(int16_t x, int16_t y, int16_t w, int16_t h, int16_t dx);
+  // With hardware scroll enabled, scrollRegionLeft() also shifts controller RAM with the content
+  // scroll command (one column per command, paced by update()), so only the exposed columns are
+  // resent. Not all SSD1306 clones implement the command; off by default.
+  void setHardwareScroll(bool enabled);
 
   void drawChar(int16_t x, int16_t y, char c, uint8_t color);
   void setCursor(int16_t x, int16_t y);
@@ -39,24 +104,92 @@ class SSD1306 {
   void print(char c);
   void getTextBounds(const char* str, int16_t x, int16_t y, int16_t* x1, int16_t* y1, uint16_t* w, uint16_t* h);
 
+#  ifdef SSD1306_STATISTICS
+  // Bytes handed to Wire (control bytes included, address bytes excluded) since construction.
+  uint32_t getBytesSent() const;
+#  endif
+
  private:
-  void sendCommand(uint8_t cmd);
   void sendCommandList(const uint8_t* cmds, uint8_t count);
-  void sendBuffer();
+  bool startNextRun();
+  void sendWindow(uint8_t page, uint8_t startCol, uint8_t endCol);
+  void sendBurst();
+  bool pumpContentScroll();
+  uint8_t findChangedColumn(uint16_t base, uint8_t col, uint8_t endCol);
+  uint8_t findUnchangedColumn(uint16_t base, uint8_t col, uint8_t endCol);
+  uint8_t panelWidth() const;
+  uint8_t panelHeight() const;
+#  ifdef SSD1306_QUARTER_ROTATION
+  void transposeCanvas();
+  void transposeDirtyRanges();
+  uint8_t transposedByte(uint8_t col);
+#  endif
 
-  void drawDiagLine(int16_t x, int16_t y, int16_t len, int8_t xdir, int8_t ydir, uint8_t color = SSD1306_WHITE);
+  void markDirty(int16_t x0, int16_t y0, int16_t x1, int16_t y1);
+  void markDirtyPages(uint8_t x0, uint8_t x1, uint8_t firstPage, uint8_t lastPage);
+  void markAllDirty();
+
+  void drawColumnSpan(int16_t x, int16_t y0, int16_t y1, uint8_t color);
 
   TwoWire* _wire;
   uint8_t _address;
+  // Drawing area; the panel geometry, or its transpose after a quarter turn.
+#  if defined(SSD1306_FIXED_GEOMETRY) && !defined(SSD1306_QUARTER_ROTATION)
+  static constexpr uint8_t _width = SSD1306_WIDTH;
+  static constexpr uint8_t _height = SSD1306_HEIGHT;
+#  else
   uint8_t _width;
   uint8_t _height;
+#  endif
+#  ifdef SSD1306_FIXED_GEOMETRY
+  // The constructor was given the geometry fixed at build time.
+  bool _geometryValid;
+#  endif
   uint8_t* _buffer;
+  uint8_t* _shadowBuffer;
+  bool _shadowValid;
+
+  // Flush progress: page being sent, next column to examine and its dirty end, and the run in flight.
+  bool _flushing;
+  bool _pageActive;
+  uint8_t _flushPage;
+  uint8_t _flushCol;
+  uint8_t _flushEndCol;
+  uint8_t _runPos;
+  uint8_t _runEnd;
+
+  // Content scroll queued for the next flush: commands left, region and time of the last command.
+  bool _hardwareScroll;
+  bool _scrollActive;
+  uint8_t _scrollPending;
+  uint8_t _scrollStartPage;
+  uint8_t _scrollEndPage;
+  uint8_t _scrollStartCol;
+  uint8_t _scrollEndCol;
+  unsigned long _scrollTime;
   int16_t _cursorX;
   int16_t _cursorY;
   uint8_t _textColor;
   uint8_t _textBgColor;
   uint8_t _textSize;
   uint8_t _colOffset;
+  uint8_t _rotation;
+#  ifdef SSD1306_QUARTER_ROTATION
+  // Panel bytes of the last transposed 8x8 block of the page being flushed.
+  uint8_t _block[8];
+  uint8_t _blockIndex;
+#  endif
+
+  // Per page column range touched since the last flush, and range that may hold lit pixels.
+  // An empty range has min > max.
+  uint8_t _dirtyMin[SSD1306_MAX_PAGES];
+  uint8_t _dirtyMax[SSD1306_MAX_PAGES];
+  uint8_t _inkMin[SSD1306_MAX_PAGES];
+  uint8_t _inkMax[SSD1306_MAX_PAGES];
+
+#  ifdef SSD1306_STATISTICS
+  uint32_t _bytesSent;
+#  endif
 };
 
 #endif  // SSD1306_H
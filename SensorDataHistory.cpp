@@ -4,47 +4,128 @@
 
 #include "SensorDataHistory.h"
 
-SensorDataHistory::SensorDataHistory(int16_t* buffer, size_t size) : buffer(buffer), size(size), count(0) {}
+SensorDataHistory::SensorDataHistory(int16_t* buffer, size_t size, uint16_t* minIndexBuffer, uint16_t* maxIndexBuffer)
+    : buffer(buffer), size(size), count(0), head(0), sequence(0) {
+  bool tracking = (minIndexBuffer != nullptr && maxIndexBuffer != nullptr && size <= UINT16_MAX);
+  minQueue.items = tracking ? minIndexBuffer : nullptr;
+  minQueue.head = 0;
+  minQueue.length = 0;
+  maxQueue.items = tracking ? maxIndexBuffer : nullptr;
+  maxQueue.head = 0;
+  maxQueue.length = 0;
+}
 
 void SensorDataHistory::begin() {
   count = 0;
+  head = 0;
+  sequence = 0;
+  minQueue.head = 0;
+  minQueue.length = 0;
+  maxQueue.head = 0;
+  maxQueue.length = 0;
 }
 
 void SensorDataHistory::prepend(int16_t value) {
-  for (size_t i = (count == size ? size - 1 : count); i > 0; i--) {
-    buffer[i] = buffer[i - 1];
-  }
-  buffer[0] = value;
+  if (size == 0) return;
+  // The buffer is used as a ring; head always points at the newest value.
+  head = (head == 0) ? size - 1 : head - 1;
+  buffer[head] = value;
   if (count < size) count++;
+
+  uint16_t seq = sequence++;
+  if (minQueue.items == nullptr) return;
+
+  expireQueue(minQueue, seq);
+  expireQueue(maxQueue, seq);
+  if (IS_VALID_SENSOR_VALUE(value)) {
+    pushQueue(minQueue, seq, value, true);
+    pushQueue(maxQueue, seq, value, false);
+  }
 }
 
 size_t SensorDataHistory::getCount() const {
   return count;
 }
 
+uint16_t SensorDataHistory::getSequence() const {
+  return sequence;
+}
+
 int16_t SensorDataHistory::getValue(size_t index) const {
   if (index < count) {
-    return buffer[index];
+    return buffer[toBufferIndex(index)];
   }
   return INVALID_SENSOR_VALUE;
 }
 
 void SensorDataHistory::getMinMaxValue(size_t count, int16_t& minValue, int16_t& maxValue) const {
+  if (minQueue.items == nullptr || count < this->count) {
+    scanMinMaxValue(count, minValue, maxValue);
+    return;
+  }
+
+  if (minQueue.length == 0) {
+    minValue = INVALID_SENSOR_VALUE;
+    maxValue = INVALID_SENSOR_VALUE;
+    return;
+  }
+  minValue = getValueBySequence(minQueue.items[minQueue.head]);
+  maxValue = getValueBySequence(maxQueue.items[maxQueue.head]);
+}
+
+size_t SensorDataHistory::toBufferIndex(size_t index) const {
+  size_t pos = head + index;
+  return (pos >= size) ? pos - size : pos;
+}
+
+size_t SensorDataHistory::toQueueIndex(const ExtremumQueue& queue, size_t index) const {
+  size_t pos = queue.head + index;
+  return (pos >= size) ? pos - size : pos;
+}
+
+int16_t SensorDataHistory::getValueBySequence(uint16_t seq) const {
+  uint16_t newestSeq = sequence - 1;
+  return buffer[toBufferIndex(static_cast<uint16_t>(newestSeq - seq))];
+}
+
+void SensorDataHistory::expireQueue(ExtremumQueue& queue, uint16_t newestSeq) {
+  while (queue.length > 0 && static_cast<uint16_t>(newestSeq - queue.items[queue.head]) >= size) {
+    if (++queue.head == size) queue.head = 0;
+    queue.length--;
+  }
+}
+
+void SensorDataHistory::pushQueue(ExtremumQueue& queue, uint16_t seq, int16_t value, bool keepMin) {
+  while (queue.length > 0) {
+    size_t back = toQueueIndex(queue, queue.length - 1);
+    int16_t backValue = getValueBySequence(queue.items[back]);
+    if (keepMin ? (backValue < value) : (backValue > value)) break;
+    queue.length--;
+  }
+  queue.items[toQueueIndex(queue, queue.length)] = seq;
+  queue.length++;
+}
+
+void SensorDataHistory::scanMinMaxValue(size_t count, int16_t& minValue, int16_t& maxValue) const {
   minValue = INVALID_SENSOR_VALUE;
   maxValue = INVALID_SENSOR_VALUE;
   bool foundValid = false;
 
   size_t checkCount = (this->count < count) ? this->count : count;
 
+  size_t pos = head;
   for (size_t i = 0; i < checkCount; i++) {
-    if (IS_VALID_SENSOR_VALUE(buffer[i])) {
+    int16_t value = buffer[pos];
+    if (++pos == size) pos = 0;
+
+    if (IS_VALID_SENSOR_VALUE(value)) {
       if (!foundValid) {
-        minValue = buffer[i];
-        maxValue = buffer[i];
+        minValue = value;
+        maxValue = value;
         foundValid = true;
       } else {
-        if (buffer[i] < minValue) minValue = buffer[i];
-        if (buffer[i] > maxValue) maxValue = buffer[i];
+        if (value < minValue) minValue = value;
+        if (value > maxValue) maxValue = value;
       }
     }
   }
@@ -11,19 +11,43 @@
 
 class SensorDataHistory {
  public:
-  SensorDataHistory(int16_t* buffer, size_t size);
+  // minIndexBuffer/maxIndexBuffer (each `size` entries) enable incremental min/max tracking over
+  // the whole history: getMinMaxValue() answers from them only when count covers every stored
+  // value and scans shorter windows, so size the history to the chart window. Without them, or
+  // with size above 65535 (sample sequences are 16 bits), getMinMaxValue() always scans.
+  SensorDataHistory(int16_t* buffer, size_t size, uint16_t* minIndexBuffer = nullptr, uint16_t* maxIndexBuffer = nullptr);
 
   void begin();
   void prepend(int16_t value);
 
   size_t getCount() const;
+  // Number of values prepended since begin(); wraps around.
+  uint16_t getSequence() const;
   int16_t getValue(size_t index) const;
   void getMinMaxValue(size_t count, int16_t& minValue, int16_t& maxValue) const;
 
  private:
+  // Monotonic deque of sample sequence numbers, oldest at the front.
+  struct ExtremumQueue {
+    uint16_t* items;
+    size_t head;
+    size_t length;
+  };
+
+  size_t toBufferIndex(size_t index) const;
+  size_t toQueueIndex(const ExtremumQueue& queue, size_t index) const;
+  int16_t getValueBySequence(uint16_t seq) const;
+  void expireQueue(ExtremumQueue& queue, uint16_t newestSeq);
+  void pushQueue(ExtremumQueue& queue, uint16_t seq, int16_t value, bool keepMin);
+  void scanMinMaxValue(size_t count, int16_t& minValue, int16_t& maxValue) const;
+
   int16_t* buffer;
   size_t size;
   size_t count;
+  size_t head;
+  uint16_t sequence;
+  ExtremumQueue minQueue;
+  ExtremumQueue maxQueue;
 };
 
 #endif  // SENSOR_DATA_HISTORY_H
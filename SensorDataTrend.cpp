@@ -0,0 +1,135 @@
+// SensorDataTrend.cpp - Downsampled sensor data history (minute / hour / day)
+
+#include "SensorDataTrend.h"
+
+static const unsigned long MINUTE_MS = 60000UL;
+
+// Number of buckets of the previous tier that make up one bucket of this tier.
+static const uint16_t TIER_PERIODS[SensorDataTrend::TIER_COUNT] = {0, 60, 24};
+
+SensorDataTrend::SensorDataTrend(Bucket* buffer, size_t size) : buffer(buffer), size(size), bucketStartTime(0), started(false), sequence(0) {
+  begin();
+}
+
+void SensorDataTrend::begin() {
+  for (uint8_t tier = 0; tier < TIER_COUNT; tier++) {
+    heads[tier] = 0;
+    counts[tier] = 0;
+    resetAccumulator(accumulators[tier]);
+  }
+  bucketStartTime = 0;
+  started = false;
+  sequence = 0;
+}
+
+void SensorDataTrend::add(int16_t value, unsigned long now) {
+  if (!started) {
+    bucketStartTime = now;
+    started = true;
+  }
+
+  if (now - bucketStartTime >= MINUTE_MS) {
+    closeBucket(TIER_MINUTE);
+    bucketStartTime += MINUTE_MS;
+    // Minutes without samples close as invalid buckets, so older buckets keep their age. A gap
+    // longer than the tier has rolled every bucket out; restart the minute grid at `now`.
+    size_t skipped = 0;
+    while (now - bucketStartTime >= MINUTE_MS && skipped < size) {
+      closeBucket(TIER_MINUTE);
+      bucketStartTime += MINUTE_MS;
+      skipped++;
+    }
+    if (now - bucketStartTime >= MINUTE_MS) {
+      bucketStartTime = now;
+    }
+  }
+
+  Bucket sample = {value, value, value};
+  accumulate(TIER_MINUTE, sample);
+}
+
+size_t SensorDataTrend::getSize() const {
+  return size;
+}
+
+size_t SensorDataTrend::getCount(Tier tier) const {
+  return counts[tier];
+}
+
+SensorDataTrend::Bucket SensorDataTrend::getBucket(Tier tier, size_t index) const {
+  if (index >= counts[tier]) {
+    Bucket invalid = {INVALID_SENSOR_VALUE, INVALID_SENSOR_VALUE, INVALID_SENSOR_VALUE};
+    return invalid;
+  }
+  size_t pos = heads[tier] + index;
+  if (pos >= size) pos -= size;
+  return buffer[tier * size + pos];
+}
+
+void SensorDataTrend::getMinMaxValue(Tier tier, size_t count, int16_t& minValue, int16_t& maxValue) const {
+  minValue = INVALID_SENSOR_VALUE;
+  maxValue = INVALID_SENSOR_VALUE;
+
+  size_t checkCount = (counts[tier] < count) ? counts[tier] : count;
+  for (size_t i = 0; i < checkCount; i++) {
+    Bucket bucket = getBucket(tier, i);
+    if (!IS_VALID_SENSOR_VALUE(bucket.meanValue)) {
+      continue;
+    }
+    if (!IS_VALID_SENSOR_VALUE(minValue) || bucket.minValue < minValue) minValue = bucket.minValue;
+    if (!IS_VALID_SENSOR_VALUE(maxValue) || bucket.maxValue > maxValue) maxValue = bucket.maxValue;
+  }
+}
+
+uint16_t SensorDataTrend::getSequence() const {
+  return sequence;
+}
+
+void SensorDataTrend::resetAccumulator(Accumulator& acc) {
+  acc.sum = 0;
+  acc.minValue = INVALID_SENSOR_VALUE;
+  acc.maxValue = INVALID_SENSOR_VALUE;
+  acc.validCount = 0;
+  acc.periodCount = 0;
+}
+
+void SensorDataTrend::closeBucket(uint8_t tier) {
+  Accumulator& acc = accumulators[tier];
+
+  Bucket bucket = {INVALID_SENSOR_VALUE, INVALID_SENSOR_VALUE, INVALID_SENSOR_VALUE};
+  if (acc.validCount > 0) {
+    bucket.minValue = acc.minValue;
+    bucket.maxValue = acc.maxValue;
+    bucket.meanValue = static_cast<int16_t>(acc.sum / acc.validCount);
+  }
+  resetAccumulator(acc);
+  push(tier, bucket);
+
+  uint8_t nextTier = tier + 1;
+  if (nextTier < TIER_COUNT) {
+    accumulate(nextTier, bucket);
+    if (accumulators[nextTier].periodCount >= TIER_PERIODS[nextTier]) {
+      closeBucket(nextTier);
+    }
+  }
+}
+
+void SensorDataTrend::accumulate(uint8_t tier, const Bucket& bucket) {
+  Accumulator& acc = accumulators[tier];
+  acc.periodCount++;
+  if (!IS_VALID_SENSOR_VALUE(bucket.meanValue)) {
+    return;
+  }
+  if (acc.validCount == 0 || bucket.minValue < acc.minValue) acc.minValue = bucket.minValue;
+  if (acc.validCount == 0 || bucket.maxValue > acc.maxValue) acc.maxValue = bucket.maxValue;
+  acc.sum += bucket.meanValue;
+  acc.validCount++;
+}
+
+void SensorDataTrend::push(uint8_t tier, const Bucket& bucket) {
+  if (size == 0) return;
+  heads[tier] = (heads[tier] == 0) ? size - 1 : heads[tier] - 1;
+  buffer[tier * size + heads[tier]] = bucket;
+  if (counts[tier] < size) counts[tier]++;
+  sequence++;
+}
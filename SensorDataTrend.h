@@ -0,0 +1,64 @@
+// SensorDataTrend.h - Downsampled sensor data history (minute / hour / day)
+
+#pragma once
+
+#ifndef SENSOR_DATA_TREND_H
+#  define SENSOR_DATA_TREND_H
+
+#  include <Arduino.h>
+
+#  include "SensorManager.h"
+
+class SensorDataTrend {
+ public:
+  enum Tier {
+    TIER_MINUTE = 0,
+    TIER_HOUR,
+    TIER_DAY,
+    TIER_COUNT,
+  };
+
+  struct Bucket {
+    int16_t minValue;
+    int16_t maxValue;
+    int16_t meanValue;
+  };
+
+  // buffer must hold TIER_COUNT * size buckets; each tier uses its own ring of `size` buckets.
+  SensorDataTrend(Bucket* buffer, size_t size);
+
+  void begin();
+  void add(int16_t value, unsigned long now);
+
+  size_t getSize() const;
+  size_t getCount(Tier tier) const;
+  Bucket getBucket(Tier tier, size_t index) const;
+  void getMinMaxValue(Tier tier, size_t count, int16_t& minValue, int16_t& maxValue) const;
+  // Number of buckets closed on any tier since begin(); wraps around. Open buckets are not listed.
+  uint16_t getSequence() const;
+
+ private:
+  struct Accumulator {
+    int32_t sum;
+    int16_t minValue;
+    int16_t maxValue;
+    uint16_t validCount;
+    uint16_t periodCount;
+  };
+
+  void resetAccumulator(Accumulator& acc);
+  void closeBucket(uint8_t tier);
+  void accumulate(uint8_t tier, const Bucket& bucket);
+  void push(uint8_t tier, const Bucket& bucket);
+
+  Bucket* buffer;
+  size_t size;
+  size_t heads[TIER_COUNT];
+  size_t counts[TIER_COUNT];
+  Accumulator accumulators[TIER_COUNT];
+  unsigned long bucketStartTime;
+  bool started;
+  uint16_t sequence;
+};
+
+#endif  // SENSOR_DATA_TREND_H
@@ -3,41 +3,77 @@
 #include "SensorManager.h"
 
 #include "DS18B20.h"
+#include "Profiler.h"
+
+#define CONVERSION_POLL_INTERVAL_MS 10
 
 SensorManager::SensorManager(DS18B20& sensor, unsigned long intervalMs)
-    : sensor(sensor), state(IDLE), requestTime(0), lastReadTime(0), lastTemperature(INVALID_SENSOR_VALUE), resultReady(false) {
-  interval = (intervalMs < 750) ? 750 : intervalMs;
+    : sensor(sensor), state(IDLE), requestTime(0), lastReadTime(0), interval(intervalMs), conversionTime(750), lastPollTime(0), lastConversionTime(0), readChannel(0), resultReady(false) {
+  for (uint8_t i = 0; i < SENSOR_MAX_CHANNELS; i++) {
+    lastTemperature[i] = INVALID_SENSOR_VALUE;
+  }
 }
 
 void SensorManager::begin() {
   sensor.begin();
+  conversionTime = sensor.getConversionTimeMs();
+  if (interval < conversionTime) {
+    interval = conversionTime;
+  }
   state = IDLE;
   requestTime = 0;
-  lastTemperature = INVALID_SENSOR_VALUE;
+  readChannel = 0;
+  for (uint8_t i = 0; i < SENSOR_MAX_CHANNELS; i++) {
+    lastTemperature[i] = INVALID_SENSOR_VALUE;
+  }
   resultReady = false;
   lastReadTime = millis() - interval;
 }
 
 void SensorManager::update() {
+  PROFILE_SCOPE(PROFILE_SENSOR_UPDATE);
+
   switch (state) {
     case IDLE:
       if (millis() - lastReadTime >= interval) {
         sensor.requestTemparature();
         requestTime = millis();
-        state = REQUESTING;
+        lastPollTime = requestTime;
+        state = sensor.isParasitePowered() ? REQUESTING : POLLING;
         resultReady = false;
       }
       break;
 
     case REQUESTING:
-      if (millis() - requestTime >= 750) {
-        state = READING;
+    case POLLING: {
+      unsigned long now = millis();
+      bool done = (now - requestTime >= conversionTime);
+      if (!done && state == POLLING && now - lastPollTime >= CONVERSION_POLL_INTERVAL_MS) {
+        lastPollTime = now;
+        done = sensor.isConversionComplete();
+      }
+      if (!done) {
+        break;
       }
-      break;
+
+      // One broadcast conversion covers every device; read them in turn.
+      lastConversionTime = now - requestTime;
+      readChannel = 0;
+      sensor.beginReadTemparature(readChannel);
+      state = READING;
+    } break;
 
     case READING: {
-      if (!sensor.readTemparature(lastTemperature)) {
-        lastTemperature = INVALID_TEMPERATURE_VALUE;
+      DS18B20::ReadStatus status = sensor.pollReadTemparature(lastTemperature[readChannel]);
+      if (status == DS18B20::READ_BUSY) {
+        break;
+      }
+      if (status == DS18B20::READ_FAILED) {
+        lastTemperature[readChannel] = INVALID_TEMPERATURE_VALUE;
+      }
+      if (++readChannel < getChannelCount()) {
+        sensor.beginReadTemparature(readChannel);
+        break;
       }
       resultReady = true;
       lastReadTime = millis();
@@ -56,6 +92,49 @@ bool SensorManager::isReady() const {
 
 SensorManager::SensorData SensorManager::getSensorData() const {
   SensorData data;
-  data.temperature = lastTemperature;
+  data.channelCount = getChannelCount();
+  for (uint8_t i = 0; i < SENSOR_MAX_CHANNELS; i++) {
+    data.temperature[i] = lastTemperature[i];
+  }
+  data.resolution = sensor.getResolution();
+  data.conversionTimeMs = static_cast<uint16_t>(lastConversionTime);
   return data;
 }
+
+uint8_t SensorManager::getChannelCount() const {
+  return sensor.getDeviceCount();
+}
+
+unsigned long SensorManager::getLastConversionTimeMs() const {
+  return lastConversionTime;
+}
+
+static unsigned long remainingMillis(unsigned long now, unsigned long since, unsigned long duration) {
+  unsigned long elapsed = now - since;
+  return (elapsed >= duration) ? 0 : duration - elapsed;
+}
+
+unsigned long SensorManager::getMillisUntilNextEvent() const {
+  if (resultReady) {
+    return 0;
+  }
+
+  unsigned long now = millis();
+  switch (state) {
+    case IDLE:
+      return remainingMillis(now, lastReadTime, interval);
+
+    case REQUESTING:
+      return remainingMillis(now, requestTime, conversionTime);
+
+    case POLLING: {
+      unsigned long timeout = remainingMillis(now, requestTime, conversionTime);
+      unsigned long poll = remainingMillis(now, lastPollTime, CONVERSION_POLL_INTERVAL_MS);
+      return (poll < timeout) ? poll : timeout;
+    }
+
+    case READING:
+    default:
+      return 0;
+  }
+}
@@ -7,18 +7,23 @@
 
 #  include <Arduino.h>
 
+#  include "DS18B20.h"
+
 #  define INVALID_SENSOR_VALUE INT16_MIN
 #  define IS_VALID_SENSOR_VALUE(value) ((value) != INVALID_SENSOR_VALUE)
 
 #  define INVALID_TEMPERATURE_VALUE INT16_MIN
 #  define IS_VALID_TEMPERATURE(value) ((value) != INVALID_TEMPERATURE_VALUE)
 
-class DS18B20;
+#  define SENSOR_MAX_CHANNELS DS18B20_MAX_DEVICES
 
 class SensorManager {
  public:
   struct SensorData {
-    int16_t temperature;
+    int16_t temperature[SENSOR_MAX_CHANNELS];
+    uint8_t channelCount;
+    uint8_t resolution;          // sensor resolution in bits
+    uint16_t conversionTimeMs;  // time from CONVERT T until the conversion was seen finished
   };
 
   SensorManager(DS18B20& sensor, unsigned long intervalMs = 3000);
@@ -27,17 +32,27 @@ class SensorManager {
   void update();
 
   bool isReady() const;
+  uint8_t getChannelCount() const;
+  unsigned long getLastConversionTimeMs() const;
+  // Milliseconds until update() next has work to do; 0 if it should be called right away.
+  unsigned long getMillisUntilNextEvent() const;
   SensorData getSensorData() const;
 
  private:
-  enum State { IDLE, REQUESTING, READING };
+  // REQUESTING waits out the worst-case conversion time; POLLING watches the bus for the
+  // conversion to finish (external power only) with that time as a fallback timeout.
+  enum State { IDLE, REQUESTING, POLLING, READING };
 
   DS18B20& sensor;
   State state;
   unsigned long requestTime;
   unsigned long lastReadTime;
   unsigned long interval;
-  int16_t lastTemperature;
+  unsigned long conversionTime;
+  unsigned long lastPollTime;
+  unsigned long lastConversionTime;
+  uint8_t readChannel;
+  int16_t lastTemperature[SENSOR_MAX_CHANNELS];
   bool resultReady;
 };
 
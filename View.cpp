@@ -2,22 +2,41 @@
 
 #include "View.h"
 
+#include "ChartScale.h"
 #include "Model.h"
+#include "Profiler.h"
 #include "SensorDataHistory.h"
+#include "SensorDataTrend.h"
 #include "SensorManager.h"
 #include "SSD1306.h"
 
 View::View(Model& model, SSD1306& display, uint8_t horizontalStep)
-    : model(model), display(display), flipped(false), viewMode(View::VIEW_MODE_CHART), horizontalStep(horizontalStep) {
+    : model(model), display(display), horizontalStep(horizontalStep), viewMode(View::VIEW_MODE_CHART), channel(0), rotation(0), chartValid(false), chartSequence(0), chartMinValue(0), chartMaxValue(0), renderValid(false), renderedGeneration(0), renderedValue(0), renderedChartSequence(0) {
 }
 
 void View::begin() {
   display.begin();
 }
 
-void View::render() {
-  display.setRotation(flipped ? 2 : 0);
-  display.clearDisplay();
+bool View::render() {
+  PROFILE_SCOPE(PROFILE_VIEW_RENDER);
+
+  // The framebuffer is still being transmitted; render on a later call.
+  if (display.isBusy()) {
+    return false;
+  }
+
+  // The frame on screen still shows the same value and chart: skip drawing and the transfer.
+  if (isRenderCurrent()) {
+    return true;
+  }
+
+  display.setRotation(rotation);
+  // The history chart clears only what it redraws; see renderChart().
+  if (viewMode != VIEW_MODE_CHART) {
+    display.clearDisplay();
+    chartValid = false;
+  }
   switch (viewMode) {
     case VIEW_MODE_TEXT:
       renderText();
@@ -26,49 +45,141 @@ void View::render() {
     case VIEW_MODE_CHART:
       renderChart();
       break;
+
+    case VIEW_MODE_CHART_MINUTE:
+      renderTrendChart(SensorDataTrend::TIER_MINUTE, "1m");
+      break;
+
+    case VIEW_MODE_CHART_HOUR:
+      renderTrendChart(SensorDataTrend::TIER_HOUR, "1h");
+      break;
+
+    case VIEW_MODE_CHART_DAY:
+      renderTrendChart(SensorDataTrend::TIER_DAY, "1d");
+      break;
+
+    default:
+      break;
   }
-  display.display();
+  display.displayAsync();
+  return true;
+}
+
+void View::invalidate() {
+  renderValid = false;
 }
 
 void View::flip() {
-  flipped = !flipped;
+  setRotation(rotation ^ 2);
+}
+
+void View::setRotation(uint8_t rotation) {
+  this->rotation = rotation;
+  chartValid = false;
+  renderValid = false;
 }
 
 void View::switchToNextViewMode() {
   viewMode = static_cast<ViewMode>((static_cast<int>(viewMode) + 1) % View::VIEW_MODE_COUNT);
+  // After the last mode, move on to the next sensor channel.
+  if (viewMode == 0) {
+    channel = (channel + 1) % model.getChannelCount();
+  }
+  chartValid = false;
+  renderValid = false;
 }
 
 void View::setViewMode(ViewMode mode) {
   viewMode = mode;
+  chartValid = false;
+  renderValid = false;
+}
+
+// Maps a centi-degree value to what formatCentiValue() prints: one key per tenth, with "-0.x"
+// distinct from "0.x".
+static int16_t getDisplayedValueKey(int16_t value) {
+  if (!IS_VALID_TEMPERATURE(value)) {
+    return value;
+  }
+  return (value < 0) ? -(-value / 10) - 1 : value / 10;
+}
+
+// Returns the sequence of the data the current mode charts; it changes whenever the chart would.
+uint16_t View::getChartSequence() const {
+  switch (viewMode) {
+    case VIEW_MODE_CHART:
+      return model.getTemperatureHistory(channel).getSequence();
+
+    case VIEW_MODE_CHART_MINUTE:
+    case VIEW_MODE_CHART_HOUR:
+    case VIEW_MODE_CHART_DAY:
+      return model.getTemperatureTrend(channel).getSequence();
+
+    default:
+      return 0;
+  }
+}
+
+// Compares the inputs of the next frame with those of the frame on screen and records them.
+// Returns true if the frame on screen is still current.
+bool View::isRenderCurrent() {
+  uint16_t generation = model.getGeneration();
+  if (renderValid && generation == renderedGeneration) {
+    return true;
+  }
+
+  int16_t value = getDisplayedValueKey(model.getTemperature(channel));
+  uint16_t chartSequence = getChartSequence();
+  bool current = renderValid && value == renderedValue && chartSequence == renderedChartSequence;
+
+  renderValid = true;
+  renderedGeneration = generation;
+  renderedValue = value;
+  renderedChartSequence = chartSequence;
+  return current;
 }
 
 void View::renderText() {
   Rect rect = {0, 0, display.getWidth(), display.getHeight()};
-  drawSensorData(model.getTemperature(), "C", rect, TEXT_SIZE_LARGE, HALIGN_CENTER, VALIGN_CENTER, false);
+  drawSensorData(model.getTemperature(channel), UNIT_CELSIUS, rect, TEXT_SIZE_LARGE, HALIGN_CENTER, VALIGN_CENTER, false);
+  drawChannelLabel(rect, VALIGN_TOP);
 }
 
 void View::renderChart() {
   const uint8_t textHeight = 16;
   Rect textRect = {0, 0, display.getWidth(), textHeight};
-  Rect rect = {0, textRect.y + textRect.h, display.getWidth(), display.getHeight() - textRect.h};
-  drawSensorDataHistory(model.getTemperatureHistory(), rect, horizontalStep);
-  drawSensorData(model.getTemperature(), "C", textRect, TEXT_SIZE_MEDIUM, HALIGN_LEFT, VALIGN_TOP, true);
+  Rect rect = {0, (int16_t)(textRect.y + textRect.h), display.getWidth(), (int16_t)(display.getHeight() - textRect.h)};
+  SensorDataHistory& history = model.getTemperatureHistory(channel);
+  if (scrollSensorDataHistory(history, rect, horizontalStep)) {
+    display.fillRect(textRect.x, textRect.y, textRect.w, textRect.h, SSD1306_BLACK);
+  } else {
+    display.clearDisplay();
+    drawSensorDataHistory(history, rect, horizontalStep);
+  }
+  drawSensorData(model.getTemperature(channel), UNIT_CELSIUS, textRect, TEXT_SIZE_MEDIUM, HALIGN_LEFT, VALIGN_TOP, true);
+  drawChannelLabel(textRect, VALIGN_BOTTOM);
+}
+
+void View::renderTrendChart(uint8_t tier, const char* label) {
+  const uint8_t textHeight = 16;
+  Rect textRect = {0, 0, display.getWidth(), textHeight};
+  Rect rect = {0, (int16_t)(textRect.y + textRect.h), display.getWidth(), (int16_t)(display.getHeight() - textRect.h)};
+  drawSensorDataTrend(model.getTemperatureTrend(channel), tier, rect);
+  drawSensorData(model.getTemperature(channel), UNIT_CELSIUS, textRect, TEXT_SIZE_MEDIUM, HALIGN_LEFT, VALIGN_TOP, true);
+  drawLabel(label, textRect, VALIGN_TOP);
+  drawChannelLabel(textRect, VALIGN_BOTTOM);
 }
 
 void View::drawSensorDataHistory(SensorDataHistory& history, const Rect& rect, uint8_t horizontalStep) {
+  chartValid = false;
   if (rect.w <= 0 || rect.h <= 0 || horizontalStep == 0) {
     return;
   }
 
-  const int16_t chartX = rect.x;
-  const int16_t chartY = rect.y;
-  const int16_t chartW = rect.w;
-  const int16_t chartH = rect.h;
-
   size_t count = history.getCount();
 
   if (count >= 2) {
-    size_t maxDataPoints = (chartW + horizontalStep - 1) / horizontalStep + 1;
+    size_t maxDataPoints = (rect.w + horizontalStep - 1) / horizontalStep + 1;
     size_t drawCount = count < maxDataPoints ? count : maxDataPoints;
 
     int16_t minValue, maxValue;
@@ -78,67 +189,229 @@ void View::drawSensorDataHistory(SensorDataHistory& history, const Rect& rect, u
       return;
     }
 
-    int16_t range = maxValue - minValue;
+    drawSensorDataHistorySegments(history, 0, drawCount - 1, rect, horizontalStep, maxValue, maxValue - minValue);
 
-    for (size_t i = 0; i < drawCount - 1; i++) {
-      int16_t currentValue = history.getValue(i);
-      int16_t nextValue = history.getValue(i + 1);
+    chartValid = true;
+    chartSequence = history.getSequence();
+    chartMinValue = minValue;
+    chartMaxValue = maxValue;
+  }
+}
 
-      if (IS_VALID_TEMPERATURE(currentValue) && IS_VALID_TEMPERATURE(nextValue)) {
-        int16_t currentY, nextY;
+// Scrolls the chart drawn by drawSensorDataHistory() left by one sample and draws only the newest
+// segment. Returns false when that would not match a full redraw: a different chart is on screen,
+// more than one sample arrived, or the autoscaled range changed.
+bool View::scrollSensorDataHistory(SensorDataHistory& history, const Rect& rect, uint8_t horizontalStep) {
+  if (!chartValid || history.getSequence() != (uint16_t)(chartSequence + 1)) {
+    return false;
+  }
 
-        if (range == 0) {
-          currentY = chartY + chartH / 2;
-          nextY = chartY + chartH / 2;
-        } else {
-          currentY = chartY + (int16_t)(((int32_t)(maxValue - currentValue) * (chartH - 1)) / range);
-          nextY = chartY + (int16_t)(((int32_t)(maxValue - nextValue) * (chartH - 1)) / range);
-        }
+  size_t count = history.getCount();
+  size_t maxDataPoints = (rect.w + horizontalStep - 1) / horizontalStep + 1;
+  size_t drawCount = count < maxDataPoints ? count : maxDataPoints;
 
-        int16_t currentX = chartX + chartW - 1 - (i * horizontalStep);
-        int16_t nextX = chartX + chartW - 1 - ((i + 1) * horizontalStep);
-        display.drawLine(currentX, currentY, nextX, nextY);
-      }
+  int16_t minValue, maxValue;
+  history.getMinMaxValue(drawCount, minValue, maxValue);
+  if (minValue != chartMinValue || maxValue != chartMaxValue) {
+    return false;
+  }
+
+  if (!display.scrollRegionLeft(rect.x, rect.y, rect.w, rect.h, horizontalStep)) {
+    return false;
+  }
+
+  drawSensorDataHistorySegments(history, 0, 1, rect, horizontalStep, maxValue, maxValue - minValue);
+  chartSequence = history.getSequence();
+  return true;
+}
+
+// Draws count lines from sample index (0 = newest, at the right edge) towards older samples. Each
+// sample is scaled once and its row carried to the next line; invalid samples leave gaps.
+void View::drawSensorDataHistorySegments(SensorDataHistory& history, size_t index, size_t count, const Rect& rect, uint8_t horizontalStep, int16_t maxValue, int16_t range) {
+  ChartScale scale = makeChartScale(maxValue, range, rect.y, rect.h);
+
+  int16_t currentValue = history.getValue(index);
+  int16_t currentY = IS_VALID_TEMPERATURE(currentValue) ? scaleToChartY(scale, currentValue) : 0;
+  int16_t currentX = rect.x + rect.w - 1 - (index * horizontalStep);
+
+  for (size_t end = index + count; index < end; index++) {
+    int16_t nextValue = history.getValue(index + 1);
+    int16_t nextY = IS_VALID_TEMPERATURE(nextValue) ? scaleToChartY(scale, nextValue) : 0;
+    int16_t nextX = currentX - horizontalStep;
+
+    if (IS_VALID_TEMPERATURE(currentValue) && IS_VALID_TEMPERATURE(nextValue)) {
+      display.drawLine(currentX, currentY, nextX, nextY);
     }
+    currentValue = nextValue;
+    currentY = nextY;
+    currentX = nextX;
   }
 }
 
-void View::drawSensorData(int16_t value, const char* unit, const Rect& rect, TextSize textSize, HorizontalAlign hAlign, VerticalAlign vAlign, bool withBackground) {
-  static char valueTextBuffer[8];
-  static char unitTextBuffer[4];
+void View::drawSensorDataTrend(SensorDataTrend& trend, uint8_t tier, const Rect& rect) {
+  if (rect.w <= 0 || rect.h <= 0 || trend.getSize() < 2) {
+    return;
+  }
+
+  const SensorDataTrend::Tier trendTier = static_cast<SensorDataTrend::Tier>(tier);
+  const int16_t chartX = rect.x;
+  const int16_t chartY = rect.y;
+  const int16_t chartW = rect.w;
+  const int16_t chartH = rect.h;
 
-  strcpy(valueTextBuffer, "--.-");
-  if (IS_VALID_TEMPERATURE(value)) {
-    int16_t intPart = value / 100;
-    uint8_t fracPart = abs(value % 100) / 10;
-    if (value < 0 && intPart == 0) {
-      sprintf(valueTextBuffer, "-0.%u", fracPart);
-    } else {
-      sprintf(valueTextBuffer, "%d.%u", intPart, fracPart);
+  // Spread the whole ring over the chart width.
+  const int16_t step = (chartW + trend.getSize() - 2) / (trend.getSize() - 1);
+  size_t maxDataPoints = (chartW + step - 1) / step + 1;
+  size_t count = trend.getCount(trendTier);
+  size_t drawCount = count < maxDataPoints ? count : maxDataPoints;
+
+  int16_t minValue, maxValue;
+  trend.getMinMaxValue(trendTier, drawCount, minValue, maxValue);
+
+  if (!IS_VALID_TEMPERATURE(minValue) || !IS_VALID_TEMPERATURE(maxValue)) {
+    return;
+  }
+
+  ChartScale scale = makeChartScale(maxValue, maxValue - minValue, chartY, chartH);
+
+  for (size_t i = 0; i < drawCount; i++) {
+    SensorDataTrend::Bucket current = trend.getBucket(trendTier, i);
+    if (!IS_VALID_TEMPERATURE(current.meanValue)) {
+      continue;
+    }
+
+    int16_t currentX = chartX + chartW - 1 - (i * step);
+
+    // Min/max envelope of the bucket
+    int16_t topY = scaleToChartY(scale, current.maxValue);
+    int16_t bottomY = scaleToChartY(scale, current.minValue);
+    display.drawVLine(currentX, topY, bottomY - topY + 1);
+
+    if (i + 1 < drawCount) {
+      SensorDataTrend::Bucket next = trend.getBucket(trendTier, i + 1);
+      if (IS_VALID_TEMPERATURE(next.meanValue)) {
+        int16_t currentY = scaleToChartY(scale, current.meanValue);
+        int16_t nextY = scaleToChartY(scale, next.meanValue);
+        display.drawLine(currentX, currentY, currentX - step, nextY);
+      }
     }
   }
+}
 
-  TextSize valueSize = textSize;
-  TextSize unitSize = (textSize >= TEXT_SIZE_MEDIUM) ? static_cast<TextSize>(textSize - 1) : textSize;
+void View::drawLabel(const char* label, const Rect& rect, VerticalAlign vAlign) {
+  int16_t x1, y1;
+  uint16_t w, h;
 
-  // Add degree symbol for temperature
-  if (strcmp(unit, "C") == 0) {
-    strcpy(unitTextBuffer, "\001C");
-  } else {
-    strncpy(unitTextBuffer, unit, sizeof(unitTextBuffer) - 1);
-    unitTextBuffer[sizeof(unitTextBuffer) - 1] = '\0';
+  display.setTextSize(TEXT_SIZE_SMALL);
+  display.getTextBounds(label, 0, 0, &x1, &y1, &w, &h);
+  display.setTextColor(SSD1306_WHITE);
+
+  int16_t cursorY = rect.y;
+  switch (vAlign) {
+    case VALIGN_TOP:
+      break;
+    case VALIGN_CENTER:
+      cursorY += (rect.h - h) / 2;
+      break;
+    case VALIGN_BOTTOM:
+      cursorY += rect.h - h;
+      break;
+  }
+  display.setCursor(rect.x + rect.w - w, cursorY);
+  display.print(label);
+}
+
+void View::drawChannelLabel(const Rect& rect, VerticalAlign vAlign) {
+  if (model.getChannelCount() <= 1) {
+    return;
   }
 
+  char label[4];
+  uint8_t number = channel + 1;
+  uint8_t len = 0;
+  label[len++] = '#';
+  if (number >= 10) {
+    label[len++] = '0' + number / 10;
+  }
+  label[len++] = '0' + number % 10;
+  label[len] = '\0';
+  drawLabel(label, rect, vAlign);
+}
+
+// Without printf. Values between -0.99 and -0.01 keep their sign ("-0.5").
+uint8_t View::formatCentiValue(int16_t value, char* text) {
+  uint8_t len = 0;
+  if (!IS_VALID_TEMPERATURE(value)) {
+    text[len++] = '-';
+    text[len++] = '-';
+    text[len++] = '.';
+    text[len++] = '-';
+    text[len] = '\0';
+    return len;
+  }
+
+  if (value < 0) {
+    text[len++] = '-';
+  }
+  uint16_t tenths = (value < 0) ? (uint16_t)(-(int32_t)value) / 10 : (uint16_t)value / 10;
+  uint16_t whole = tenths / 10;
+
+  char digits[3];
+  uint8_t count = 0;
+  do {
+    digits[count++] = '0' + whole % 10;
+    whole /= 10;
+  } while (whole > 0);
+  while (count > 0) {
+    text[len++] = digits[--count];
+  }
+  text[len++] = '.';
+  text[len++] = '0' + tenths % 10;
+  text[len] = '\0';
+  return len;
+}
+
+static const char* getUnitText(View::Unit unit) {
+  switch (unit) {
+    case View::UNIT_CELSIUS:
+    default:
+      return "\001C";  // degree symbol + C
+  }
+}
+
+void View::drawSensorData(int16_t value, Unit unit, const Rect& rect, TextSize textSize, HorizontalAlign hAlign, VerticalAlign vAlign, bool withBackground) {
+  char valueText[8];
+  formatCentiValue(value, valueText);
+  const char* unitText = getUnitText(unit);
+
+  TextSize valueSize = textSize;
+  TextSize unitSize;
+
   int16_t x1, y1;
   uint16_t valueW, valueH, unitW, unitH;
+  uint16_t totalW;
 
-  display.setTextSize(valueSize);
-  display.getTextBounds(valueTextBuffer, 0, 0, &x1, &y1, &valueW, &valueH);
+  // Step the size down until the text fits the width (32 pixels in portrait), and drop the unit
+  // if even the small size is too wide.
+  while (true) {
+    unitSize = (valueSize >= TEXT_SIZE_MEDIUM) ? static_cast<TextSize>(valueSize - 1) : valueSize;
 
-  display.setTextSize(unitSize);
-  display.getTextBounds(unitTextBuffer, 0, 0, &x1, &y1, &unitW, &unitH);
+    display.setTextSize(valueSize);
+    display.getTextBounds(valueText, 0, 0, &x1, &y1, &valueW, &valueH);
 
-  uint16_t totalW = valueW + unitW;
+    display.setTextSize(unitSize);
+    display.getTextBounds(unitText, 0, 0, &x1, &y1, &unitW, &unitH);
+
+    totalW = valueW + unitW;
+    if ((int16_t)totalW <= rect.w || valueSize == TEXT_SIZE_SMALL) {
+      break;
+    }
+    valueSize = static_cast<TextSize>(valueSize - 1);
+  }
+  if ((int16_t)totalW > rect.w) {
+    unitText = "";
+    totalW = valueW;
+  }
   uint16_t totalH = valueH;
 
   int16_t cursorX = rect.x;
@@ -174,9 +447,9 @@ void View::drawSensorData(int16_t value, const char* unit, const Rect& rect, Tex
 
   display.setTextSize(valueSize);
   display.setCursor(cursorX, cursorY);
-  display.print(valueTextBuffer);
+  display.print(valueText);
 
   display.setTextSize(unitSize);
   display.setCursor(cursorX + valueW, cursorY);
-  display.print(unitTextBuffer);
+  display.print(unitText);
 }
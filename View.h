@@ -10,6 +10,7 @@
 class Model;
 class SSD1306;
 class SensorDataHistory;
+class SensorDataTrend;
 
 class View {
  public:
@@ -22,6 +23,9 @@ class View {
 
   enum ViewMode {
     VIEW_MODE_CHART = 0,
+    VIEW_MODE_CHART_MINUTE,
+    VIEW_MODE_CHART_HOUR,
+    VIEW_MODE_CHART_DAY,
     VIEW_MODE_TEXT,
     VIEW_MODE_COUNT,
   };
@@ -38,6 +42,10 @@ class View {
     VALIGN_BOTTOM,
   };
 
+  enum Unit {
+    UNIT_CELSIUS,
+  };
+
   enum TextSize {
     TEXT_SIZE_SMALL = 1,
     TEXT_SIZE_MEDIUM = 2,
@@ -47,22 +55,54 @@ class View {
   View(Model& model, SSD1306& display, uint8_t horizontalStep = 1);
 
   void begin();
-  void render();
+  // Draws the current mode and starts the transfer, or leaves the frame on screen if nothing it
+  // shows has changed. Returns false if the display is still busy with the previous frame.
+  bool render();
+  // Makes the next render() draw even if its inputs look unchanged.
+  void invalidate();
   void flip();
+  // SSD1306 rotation: 0/2 landscape, 1/3 portrait (needs SSD1306_QUARTER_ROTATION).
+  void setRotation(uint8_t rotation);
   void switchToNextViewMode();
   void setViewMode(ViewMode mode);
 
+  // Formats a centi-unit value as "[-]d.d", truncated to one decimal, or "--.-" if invalid.
+  // text needs room for 8 characters. Returns the length.
+  static uint8_t formatCentiValue(int16_t value, char* text);
+
  private:
+  uint16_t getChartSequence() const;
+  bool isRenderCurrent();
   void renderText();
   void renderChart();
-  void drawSensorData(int16_t value, const char* unit, const Rect& rect, TextSize textSize, HorizontalAlign hAlign, VerticalAlign vAlign, bool withBackground);
+  void renderTrendChart(uint8_t tier, const char* label);
+  void drawSensorData(int16_t value, Unit unit, const Rect& rect, TextSize textSize, HorizontalAlign hAlign, VerticalAlign vAlign, bool withBackground);
   void drawSensorDataHistory(SensorDataHistory& history, const Rect& rect, uint8_t horizontalStep);
+  bool scrollSensorDataHistory(SensorDataHistory& history, const Rect& rect, uint8_t horizontalStep);
+  void drawSensorDataHistorySegments(SensorDataHistory& history, size_t index, size_t count, const Rect& rect, uint8_t horizontalStep, int16_t maxValue, int16_t range);
+  void drawSensorDataTrend(SensorDataTrend& trend, uint8_t tier, const Rect& rect);
+  void drawLabel(const char* label, const Rect& rect, VerticalAlign vAlign);
+  void drawChannelLabel(const Rect& rect, VerticalAlign vAlign);
 
   Model& model;
   SSD1306& display;
   uint8_t horizontalStep;
   ViewMode viewMode;
-  bool flipped;
+  uint8_t channel;
+  uint8_t rotation;
+
+  // What the history chart in the framebuffer shows, so the next sample can scroll it in.
+  bool chartValid;
+  uint16_t chartSequence;
+  int16_t chartMinValue;
+  int16_t chartMaxValue;
+
+  // Inputs of the frame on screen: model generation, displayed value in tenths, and the sequence
+  // of the data the chart shows. Mode, channel and rotation changes clear renderValid.
+  bool renderValid;
+  uint16_t renderedGeneration;
+  int16_t renderedValue;
+  uint16_t renderedChartSequence;
 };
 
 #endif  // VIEW_H
@@ -0,0 +1,162 @@
+// Arduino.cpp - Host shim of the Arduino core for native tests and benchmarks
+
+#include "Arduino.h"
+
+#include <stdio.h>
+
+#define PIN_COUNT 64
+
+struct PinState {
+  uint8_t mode;
+  uint8_t value;
+  bool driveLow;
+  PinModel* model;
+};
+
+static unsigned long currentMicros = 0;
+static PinState pins[PIN_COUNT];
+
+unsigned long millis(void) {
+  return currentMicros / 1000;
+}
+
+// Every call costs a microsecond, so code that busy-waits on micros() makes progress.
+unsigned long micros(void) {
+  return currentMicros++;
+}
+
+void delay(unsigned long ms) {
+  currentMicros += ms * 1000;
+}
+
+void delayMicroseconds(unsigned int us) {
+  currentMicros += us;
+}
+
+void setMicros(unsigned long us) {
+  currentMicros = us;
+}
+
+void advanceMicros(unsigned long us) {
+  currentMicros += us;
+}
+
+// Tells the attached model when the pin starts or stops sinking current.
+static void updateDrive(uint8_t pin) {
+  PinState& state = pins[pin];
+  bool driveLow = (state.mode == OUTPUT && state.value == LOW);
+  if (driveLow != state.driveLow) {
+    state.driveLow = driveLow;
+    if (state.model != nullptr) {
+      state.model->drive(driveLow);
+    }
+  }
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin >= PIN_COUNT) return;
+  pins[pin].mode = mode;
+  updateDrive(pin);
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin >= PIN_COUNT) return;
+  pins[pin].value = value ? HIGH : LOW;
+  updateDrive(pin);
+}
+
+int digitalRead(uint8_t pin) {
+  if (pin >= PIN_COUNT) return LOW;
+  const PinState& state = pins[pin];
+  if (state.mode == OUTPUT) {
+    return state.value;
+  }
+  if (state.model != nullptr) {
+    return state.model->isLow() ? LOW : HIGH;
+  }
+  // Unconnected inputs idle high, like a released button with its pull-up.
+  return HIGH;
+}
+
+void noInterrupts(void) {
+}
+
+void interrupts(void) {
+}
+
+int digitalPinToInterrupt(uint8_t pin) {
+  return pin;
+}
+
+void attachInterrupt(uint8_t interrupt, void (*handler)(void), int mode) {
+  (void)interrupt;
+  (void)handler;
+  (void)mode;
+}
+
+void attachPinModel(uint8_t pin, PinModel* model) {
+  if (pin >= PIN_COUNT) return;
+  pins[pin].model = model;
+}
+
+void resetPins(void) {
+  memset(pins, 0, sizeof(pins));
+}
+
+HardwareSerial Serial;
+
+void HardwareSerial::begin(unsigned long baud) {
+  (void)baud;
+}
+
+int HardwareSerial::available(void) {
+  return 0;
+}
+
+int HardwareSerial::read(void) {
+  return -1;
+}
+
+size_t HardwareSerial::print(const char* str) {
+  return fputs(str, stdout) < 0 ? 0 : strlen(str);
+}
+
+size_t HardwareSerial::print(char c) {
+  return putchar(c) < 0 ? 0 : 1;
+}
+
+size_t HardwareSerial::print(long value) {
+  return printf("%ld", value);
+}
+
+size_t HardwareSerial::print(unsigned long value) {
+  return printf("%lu", value);
+}
+
+size_t HardwareSerial::print(int value) {
+  return printf("%d", value);
+}
+
+size_t HardwareSerial::print(unsigned int value) {
+  return printf("%u", value);
+}
+
+size_t HardwareSerial::println(const char* str) {
+  return print(str) + print('\n');
+}
+
+size_t HardwareSerial::println(long value) {
+  return print(value) + print('\n');
+}
+
+size_t HardwareSerial::println(unsigned long value) {
+  return print(value) + print('\n');
+}
+
+size_t HardwareSerial::println(int value) {
+  return print(value) + print('\n');
+}
+
+size_t HardwareSerial::println(unsigned int value) {
+  return print(value) + print('\n');
+}
@@ -0,0 +1,87 @@
+// Arduino.h - Host shim of the Arduino core for native tests and benchmarks
+
+#pragma once
+
+#ifndef ARDUINO_H
+#  define ARDUINO_H
+
+#  include <stddef.h>
+#  include <stdint.h>
+#  include <stdlib.h>
+#  include <string.h>
+
+#  define PROGMEM
+#  define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#  define pgm_read_word(addr) (*(const uint16_t*)(addr))
+
+#  define HIGH 0x1
+#  define LOW 0x0
+
+#  define INPUT 0x0
+#  define OUTPUT 0x1
+#  define INPUT_PULLUP 0x2
+
+#  define CHANGE 1
+#  define FALLING 2
+#  define RISING 3
+
+#  define PC5 21
+#  define PD0 24
+
+#  ifndef F_CPU
+#    define F_CPU 48000000UL
+#  endif
+#  define clockCyclesPerMicrosecond() (F_CPU / 1000000UL)
+
+// Simulated time: it moves through delay(), delayMicroseconds(), the helpers below, and one
+// microsecond per micros() call.
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void noInterrupts(void);
+void interrupts(void);
+int digitalPinToInterrupt(uint8_t pin);
+void attachInterrupt(uint8_t interrupt, void (*handler)(void), int mode);
+
+class HardwareSerial {
+ public:
+  void begin(unsigned long baud);
+  int available(void);
+  int read(void);
+  size_t print(const char* str);
+  size_t print(char c);
+  size_t print(long value);
+  size_t print(unsigned long value);
+  size_t print(int value);
+  size_t print(unsigned int value);
+  size_t println(const char* str = "");
+  size_t println(long value);
+  size_t println(unsigned long value);
+  size_t println(int value);
+  size_t println(unsigned int value);
+};
+
+extern HardwareSerial Serial;
+
+// Host side of a pin: something on the wire that sees the MCU pull the line low or let it go,
+// and can pull the line low itself (open drain, released line reads high).
+class PinModel {
+ public:
+  virtual ~PinModel() {
+  }
+  virtual void drive(bool low) = 0;
+  virtual bool isLow(void) = 0;
+};
+
+// Test controls for the shim.
+void setMicros(unsigned long us);
+void advanceMicros(unsigned long us);
+void attachPinModel(uint8_t pin, PinModel* model);
+void resetPins(void);
+
+#endif  // ARDUINO_H
@@ -0,0 +1,291 @@
+// DS18B20Bus.cpp - Bit-level simulation of DS18B20 devices on a 1-Wire bus for native tests
+
+#include "DS18B20Bus.h"
+
+// Pulse lengths the devices use to tell slots apart (datasheet minimum reset low time, and the
+// 15 us sampling point of a write slot).
+#define BUS_RESET_LOW_US 480
+#define BUS_SAMPLE_US 15
+// How long a device holds a 0 bit of a read slot, and its presence pulse timing.
+#define BUS_HOLD_LOW_US 30
+#define BUS_PRESENCE_DELAY_US 15
+#define BUS_PRESENCE_LOW_US 120
+
+#define BUS_MAX_CONVERSION_US 750000UL
+
+DS18B20Bus::DS18B20Bus()
+    : deviceCount(0), masterLow(false), lowStart(0), holdLowUntil(0), presenceStart(0), presenceEnd(0), resetCount(0), slotCount(0), longestLow(0) {
+}
+
+void DS18B20Bus::makeRom(uint32_t serial, uint8_t rom[8]) {
+  rom[0] = 0x28;
+  for (uint8_t i = 1; i < 7; i++) {
+    rom[i] = (i <= 4) ? (uint8_t)(serial >> ((i - 1) * 8)) : 0;
+  }
+  rom[7] = crc8(rom, 7);
+}
+
+// Bitwise Dallas/Maxim CRC8, independent of the table-driven one under test.
+uint8_t DS18B20Bus::crc8(const uint8_t* data, uint8_t len) {
+  uint8_t crc = 0;
+  while (len--) {
+    uint8_t value = *data++;
+    for (uint8_t i = 0; i < 8; i++) {
+      uint8_t mix = (crc ^ value) & 0x01;
+      crc >>= 1;
+      if (mix) crc ^= 0x8C;
+      value >>= 1;
+    }
+  }
+  return crc;
+}
+
+uint8_t DS18B20Bus::addDevice(const uint8_t rom[8], bool parasite) {
+  Device& device = devices[deviceCount];
+  memset(&device, 0, sizeof(device));
+  memcpy(device.rom, rom, 8);
+  device.parasite = parasite;
+  device.temperature = 0x0550;  // 85 degC, the power-on value
+  device.conversionMicros = BUS_MAX_CONVERSION_US;
+
+  static const uint8_t powerOnScratchpad[8] = {0x50, 0x05, 0x4B, 0x46, 0x7F, 0xFF, 0x0C, 0x10};
+  memcpy(device.scratchpad, powerOnScratchpad, sizeof(powerOnScratchpad));
+  updateScratchpadCrc(device);
+  return deviceCount++;
+}
+
+void DS18B20Bus::setTemperature(uint8_t index, int16_t raw) {
+  devices[index].temperature = raw;
+}
+
+void DS18B20Bus::setCorruptScratchpad(uint8_t index, bool corrupt) {
+  devices[index].corrupt = corrupt;
+}
+
+void DS18B20Bus::setConversionMicros(uint8_t index, unsigned long us) {
+  devices[index].conversionMicros = us;
+}
+
+uint8_t DS18B20Bus::getResolution(uint8_t index) const {
+  return 9 + ((devices[index].scratchpad[4] >> 5) & 0x03);
+}
+
+unsigned long DS18B20Bus::getResetCount(void) const {
+  return resetCount;
+}
+
+unsigned long DS18B20Bus::getSlotCount(void) const {
+  return slotCount;
+}
+
+unsigned long DS18B20Bus::getLongestLowMicros(void) const {
+  return longestLow;
+}
+
+void DS18B20Bus::drive(bool low) {
+  unsigned long now = micros();
+  if (low == masterLow) return;
+  masterLow = low;
+  if (low) {
+    lowStart = now;
+    return;
+  }
+
+  unsigned long duration = now - lowStart;
+  if (duration > longestLow) longestLow = duration;
+  if (duration >= BUS_RESET_LOW_US) {
+    reset();
+  } else {
+    slot(duration < BUS_SAMPLE_US, lowStart);
+  }
+}
+
+bool DS18B20Bus::isLow(void) {
+  unsigned long now = micros();
+  return masterLow || now < holdLowUntil || (now >= presenceStart && now < presenceEnd);
+}
+
+void DS18B20Bus::reset(void) {
+  resetCount++;
+  unsigned long now = micros();
+  for (uint8_t i = 0; i < deviceCount; i++) {
+    Device& device = devices[i];
+    finishConversion(device);
+    device.state = STATE_ROM_COMMAND;
+    device.rxBits = 0;
+    device.rxCount = 0;
+  }
+  if (deviceCount > 0) {
+    presenceStart = now + BUS_PRESENCE_DELAY_US;
+    presenceEnd = presenceStart + BUS_PRESENCE_LOW_US;
+  }
+}
+
+// One read/write slot: devices that send put their bit on the line first, then every device
+// that takes part samples the resulting wired-AND level.
+void DS18B20Bus::slot(bool masterBit, unsigned long lowStart) {
+  slotCount++;
+  bool line = masterBit;
+  for (uint8_t i = 0; i < deviceCount; i++) {
+    if (drivesLow(devices[i])) {
+      line = false;
+    }
+  }
+  if (masterBit && !line) {
+    holdLowUntil = lowStart + BUS_HOLD_LOW_US;
+  }
+  for (uint8_t i = 0; i < deviceCount; i++) {
+    clock(devices[i], line);
+  }
+}
+
+bool DS18B20Bus::drivesLow(Device& device) {
+  switch (device.state) {
+    case STATE_TRANSMIT:
+      if (device.txIndex >= device.txBits) return false;
+      return (device.tx[device.txIndex / 8] & (1 << (device.txIndex % 8))) == 0;
+
+    case STATE_SEARCH_ROM: {
+      bool bit = device.rom[device.searchBit / 8] & (1 << (device.searchBit % 8));
+      if (device.searchPhase == 0) return !bit;
+      if (device.searchPhase == 1) return bit;
+      return false;
+    }
+
+    case STATE_CONVERTING:
+      // Externally powered devices answer read slots with 0 until the conversion is done.
+      finishConversion(device);
+      return device.converting && !device.parasite;
+
+    default:
+      return false;
+  }
+}
+
+void DS18B20Bus::clock(Device& device, bool bit) {
+  switch (device.state) {
+    case STATE_ROM_COMMAND:
+    case STATE_MATCH_ROM:
+    case STATE_FUNCTION_COMMAND:
+    case STATE_WRITE_SCRATCHPAD:
+      if (bit) device.rxByte |= (1 << device.rxBits);
+      if (++device.rxBits == 8) {
+        uint8_t value = device.rxByte;
+        device.rxByte = 0;
+        device.rxBits = 0;
+        receiveByte(device, value);
+      }
+      break;
+
+    case STATE_TRANSMIT:
+      if (device.txIndex < device.txBits) device.txIndex++;
+      break;
+
+    case STATE_SEARCH_ROM:
+      if (device.searchPhase < 2) {
+        device.searchPhase++;
+        break;
+      }
+      if (bit != (bool)(device.rom[device.searchBit / 8] & (1 << (device.searchBit % 8)))) {
+        device.state = STATE_IDLE;
+        break;
+      }
+      device.searchPhase = 0;
+      if (++device.searchBit == 64) {
+        device.state = STATE_FUNCTION_COMMAND;
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+
+void DS18B20Bus::receiveByte(Device& device, uint8_t value) {
+  switch (device.state) {
+    case STATE_ROM_COMMAND:
+      if (value == 0xCC) {
+        device.state = STATE_FUNCTION_COMMAND;
+      } else if (value == 0x55) {
+        device.state = STATE_MATCH_ROM;
+        device.rxCount = 0;
+      } else if (value == 0xF0) {
+        device.state = STATE_SEARCH_ROM;
+        device.searchBit = 0;
+        device.searchPhase = 0;
+      } else if (value == 0x33) {
+        transmit(device, device.rom, 64);
+      } else {
+        device.state = STATE_IDLE;
+      }
+      break;
+
+    case STATE_MATCH_ROM:
+      if (value != device.rom[device.rxCount]) {
+        device.state = STATE_IDLE;
+      } else if (++device.rxCount == 8) {
+        device.state = STATE_FUNCTION_COMMAND;
+      }
+      break;
+
+    case STATE_FUNCTION_COMMAND:
+      if (value == 0x44) {
+        uint8_t shift = 12 - (9 + ((device.scratchpad[4] >> 5) & 0x03));
+        device.state = STATE_CONVERTING;
+        device.converting = true;
+        device.convertEnd = micros() + (device.conversionMicros >> shift);
+      } else if (value == 0xBE) {
+        finishConversion(device);
+        uint8_t data[9];
+        memcpy(data, device.scratchpad, sizeof(data));
+        if (device.corrupt) data[0] ^= 0x01;
+        transmit(device, data, 72);
+      } else if (value == 0x4E) {
+        device.state = STATE_WRITE_SCRATCHPAD;
+        device.rxCount = 0;
+      } else if (value == 0xB4) {
+        uint8_t supply = device.parasite ? 0x00 : 0xFF;
+        transmit(device, &supply, 8);
+      } else {
+        device.state = STATE_IDLE;
+      }
+      break;
+
+    case STATE_WRITE_SCRATCHPAD:
+      if (device.rxCount == 2) {
+        // Only the resolution bits of the configuration register are writable.
+        device.scratchpad[4] = (value & 0x60) | 0x1F;
+      } else {
+        device.scratchpad[2 + device.rxCount] = value;
+      }
+      if (++device.rxCount == 3) {
+        updateScratchpadCrc(device);
+        device.state = STATE_IDLE;
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+
+void DS18B20Bus::transmit(Device& device, const uint8_t* data, uint8_t bits) {
+  memcpy(device.tx, data, (bits + 7) / 8);
+  device.txBits = bits;
+  device.txIndex = 0;
+  device.state = STATE_TRANSMIT;
+}
+
+// Latches the temperature once the conversion time has passed; undefined low bits below
+// 12-bit resolution are left as they come.
+void DS18B20Bus::finishConversion(Device& device) {
+  if (!device.converting || micros() < device.convertEnd) return;
+  device.converting = false;
+  device.scratchpad[0] = (uint8_t)device.temperature;
+  device.scratchpad[1] = (uint8_t)((uint16_t)device.temperature >> 8);
+  updateScratchpadCrc(device);
+}
+
+void DS18B20Bus::updateScratchpadCrc(Device& device) {
+  device.scratchpad[8] = crc8(device.scratchpad, 8);
+}
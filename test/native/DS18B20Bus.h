@@ -0,0 +1,95 @@
+// DS18B20Bus.h - Bit-level simulation of DS18B20 devices on a 1-Wire bus for native tests
+
+#pragma once
+
+#ifndef DS18B20_BUS_H
+#  define DS18B20_BUS_H
+
+#  include <Arduino.h>
+
+#  define DS18B20_BUS_MAX_DEVICES 8
+
+// Attach to the 1-Wire pin with attachPinModel(). The bus classifies each low pulse the MCU
+// drives by its length (reset, write 0, or write 1 / read slot) using the simulated clock,
+// and the devices answer by holding the line low, as on a wired-AND bus.
+class DS18B20Bus : public PinModel {
+ public:
+  DS18B20Bus();
+
+  // Builds a ROM code with the DS18B20 family code, the given serial number and its CRC.
+  static void makeRom(uint32_t serial, uint8_t rom[8]);
+  static uint8_t crc8(const uint8_t* data, uint8_t len);
+
+  // Returns the device index.
+  uint8_t addDevice(const uint8_t rom[8], bool parasite = false);
+  // Raw reading in 1/16 degC that the next conversion of the device latches.
+  void setTemperature(uint8_t index, int16_t raw);
+  // Flips a bit of the scratchpad data the device sends, so its CRC no longer matches.
+  void setCorruptScratchpad(uint8_t index, bool corrupt);
+  // How long a 12-bit conversion of the device takes (lower resolutions take 1/2, 1/4, 1/8 of
+  // it). Defaults to the 750 ms datasheet maximum; real parts are usually faster.
+  void setConversionMicros(uint8_t index, unsigned long us);
+  uint8_t getResolution(uint8_t index) const;
+
+  unsigned long getResetCount(void) const;
+  unsigned long getSlotCount(void) const;
+  // Longest continuous low pulse driven by the MCU, in microseconds.
+  unsigned long getLongestLowMicros(void) const;
+
+  void drive(bool low) override;
+  bool isLow(void) override;
+
+ private:
+  enum State {
+    STATE_IDLE,
+    STATE_ROM_COMMAND,
+    STATE_MATCH_ROM,
+    STATE_SEARCH_ROM,
+    STATE_FUNCTION_COMMAND,
+    STATE_WRITE_SCRATCHPAD,
+    STATE_TRANSMIT,
+    STATE_CONVERTING,
+  };
+
+  struct Device {
+    uint8_t rom[8];
+    uint8_t scratchpad[9];
+    bool parasite;
+    bool corrupt;
+    int16_t temperature;
+    State state;
+    uint8_t rxByte;
+    uint8_t rxBits;
+    uint8_t rxCount;
+    uint8_t tx[9];
+    uint8_t txBits;
+    uint8_t txIndex;
+    uint8_t searchBit;
+    uint8_t searchPhase;
+    unsigned long conversionMicros;
+    unsigned long convertEnd;
+    bool converting;
+  };
+
+  void reset(void);
+  void slot(bool masterBit, unsigned long lowStart);
+  bool drivesLow(Device& device);
+  void clock(Device& device, bool bit);
+  void receiveByte(Device& device, uint8_t value);
+  void transmit(Device& device, const uint8_t* data, uint8_t bits);
+  void finishConversion(Device& device);
+  void updateScratchpadCrc(Device& device);
+
+  Device devices[DS18B20_BUS_MAX_DEVICES];
+  uint8_t deviceCount;
+  bool masterLow;
+  unsigned long lowStart;
+  unsigned long holdLowUntil;
+  unsigned long presenceStart;
+  unsigned long presenceEnd;
+  unsigned long resetCount;
+  unsigned long slotCount;
+  unsigned long longestLow;
+};
+
+#endif  // DS18B20_BUS_H
@@ -0,0 +1,245 @@
+// SSD1306Controller.cpp - Model of the SSD1306 controller RAM fed by the recording Wire shim
+
+#include "SSD1306Controller.h"
+
+// Two frames of a 32-row panel at the default clock; see SSD1306_CONTENT_SCROLL_INTERVAL_MS.
+#define CONTROLLER_SCROLL_TIME_MS 12
+
+SSD1306Controller::SSD1306Controller(uint8_t address) : address(address) {
+  reset();
+}
+
+void SSD1306Controller::reset(void) {
+  for (uint8_t p = 0; p < SSD1306_CONTROLLER_PAGES; p++) {
+    for (uint8_t c = 0; c < SSD1306_CONTROLLER_COLUMNS; c++) {
+      ram[p][c] = (uint8_t)(p * 37 + c * 11 + 0x5A);
+    }
+  }
+  addressingMode = 0x02;
+  startColumn = 0;
+  endColumn = SSD1306_CONTROLLER_COLUMNS - 1;
+  startPage = 0;
+  endPage = SSD1306_CONTROLLER_PAGES - 1;
+  column = 0;
+  page = 0;
+  displayOn = false;
+  segmentRemap = false;
+  comScanReversed = false;
+  pendingLength = 0;
+  pendingNeeded = 0;
+  scrolled = false;
+  scrollTime = 0;
+  protocolErrors = 0;
+  scrollTimingErrors = 0;
+  scrollCommands = 0;
+}
+
+void SSD1306Controller::transmission(uint8_t address, const uint8_t* data, size_t length) {
+  if (address != this->address) return;
+  if (length == 0) {
+    protocolErrors++;
+    return;
+  }
+
+  // The driver sends one control byte per transmission: all commands (Co = 0, D/C# = 0) or all
+  // data (Co = 0, D/C# = 1).
+  uint8_t control = data[0];
+  if (control == 0x00) {
+    for (size_t i = 1; i < length; i++) {
+      command(data[i]);
+    }
+  } else if (control == 0x40) {
+    for (size_t i = 1; i < length; i++) {
+      this->data(data[i]);
+    }
+  } else {
+    protocolErrors++;
+  }
+}
+
+uint8_t SSD1306Controller::getRam(uint8_t page, uint8_t column) const {
+  return ram[page][column];
+}
+
+bool SSD1306Controller::matches(const uint8_t* buffer, uint8_t width, uint8_t height, uint8_t colOffset) const {
+  for (uint8_t p = 0; p < height / 8; p++) {
+    if (memcmp(&ram[p][colOffset], &buffer[(uint16_t)p * width], width) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool SSD1306Controller::isDisplayOn(void) const {
+  return displayOn;
+}
+
+bool SSD1306Controller::isSegmentRemapped(void) const {
+  return segmentRemap;
+}
+
+bool SSD1306Controller::isComScanReversed(void) const {
+  return comScanReversed;
+}
+
+unsigned long SSD1306Controller::getProtocolErrors(void) const {
+  return protocolErrors;
+}
+
+unsigned long SSD1306Controller::getScrollTimingErrors(void) const {
+  return scrollTimingErrors;
+}
+
+unsigned long SSD1306Controller::getScrollCommands(void) const {
+  return scrollCommands;
+}
+
+// Parameter bytes that follow each multi-byte command.
+static uint8_t parameterCount(uint8_t command) {
+  switch (command) {
+    case 0x20:
+    case 0x81:
+    case 0x8D:
+    case 0xA8:
+    case 0xD3:
+    case 0xD5:
+    case 0xD9:
+    case 0xDA:
+    case 0xDB:
+      return 1;
+    case 0x21:
+    case 0x22:
+    case 0xA3:
+      return 2;
+    case 0x29:
+    case 0x2A:
+      return 5;
+    case 0x26:
+    case 0x27:
+    case 0x2C:
+    case 0x2D:
+      return 6;
+    default:
+      return 0;
+  }
+}
+
+void SSD1306Controller::command(uint8_t value) {
+  pending[pendingLength++] = value;
+  if (pendingLength == 1) {
+    pendingNeeded = parameterCount(value);
+  }
+  if (pendingLength > pendingNeeded) {
+    execute();
+    pendingLength = 0;
+  }
+}
+
+void SSD1306Controller::execute(void) {
+  uint8_t op = pending[0];
+  switch (op) {
+    case 0x20:
+      addressingMode = pending[1] & 0x03;
+      break;
+    case 0x21:
+      startColumn = pending[1] & 0x7F;
+      endColumn = pending[2] & 0x7F;
+      column = startColumn;
+      break;
+    case 0x22:
+      startPage = pending[1] & 0x07;
+      endPage = pending[2] & 0x07;
+      page = startPage;
+      break;
+    case 0x2C:
+    case 0x2D:
+      contentScroll(op == 0x2D);
+      break;
+    case 0xA0:
+    case 0xA1:
+      segmentRemap = (op == 0xA1);
+      break;
+    case 0xC0:
+    case 0xC8:
+      comScanReversed = (op == 0xC8);
+      break;
+    case 0xAE:
+    case 0xAF:
+      displayOn = (op == 0xAF);
+      break;
+    case 0x2E:
+    case 0x2F:
+    case 0x81:
+    case 0x8D:
+    case 0xA4:
+    case 0xA5:
+    case 0xA6:
+    case 0xA7:
+    case 0xA8:
+    case 0xD3:
+    case 0xD5:
+    case 0xD9:
+    case 0xDA:
+    case 0xDB:
+      break;
+    default:
+      // Display start line (0x40-0x7F) is accepted; anything else is not a command the driver sends.
+      if (op < 0x40 || op > 0x7F) {
+        protocolErrors++;
+      }
+      break;
+  }
+}
+
+void SSD1306Controller::data(uint8_t value) {
+  if (addressingMode != 0x00) {
+    protocolErrors++;
+    return;
+  }
+  if (scrolled && millis() - scrollTime < CONTROLLER_SCROLL_TIME_MS) {
+    scrollTimingErrors++;
+  }
+
+  ram[page][column] = value;
+  if (column == endColumn) {
+    column = startColumn;
+    page = (page == endPage) ? startPage : page + 1;
+  } else {
+    column = (column + 1) & 0x7F;
+  }
+}
+
+// Moves columns E..F of pages B..D one column left (0x2D) or right (0x2C); the column pushed out
+// wraps around to the other end.
+void SSD1306Controller::contentScroll(bool left) {
+  uint8_t firstPage = pending[2] & 0x07;
+  uint8_t lastPage = pending[4] & 0x07;
+  uint8_t firstColumn = pending[5] & 0x7F;
+  uint8_t lastColumn = pending[6] & 0x7F;
+  if (pending[1] != 0x00 || firstPage > lastPage || firstColumn >= lastColumn) {
+    protocolErrors++;
+    return;
+  }
+
+  unsigned long now = millis();
+  if (scrolled && now - scrollTime < CONTROLLER_SCROLL_TIME_MS) {
+    scrollTimingErrors++;
+  }
+  scrolled = true;
+  scrollTime = now;
+  scrollCommands++;
+
+  uint8_t span = lastColumn - firstColumn + 1;
+  for (uint8_t p = firstPage; p <= lastPage; p++) {
+    uint8_t* row = &ram[p][firstColumn];
+    if (left) {
+      uint8_t first = row[0];
+      memmove(row, row + 1, span - 1);
+      row[span - 1] = first;
+    } else {
+      uint8_t last = row[span - 1];
+      memmove(row + 1, row, span - 1);
+      row[0] = last;
+    }
+  }
+}
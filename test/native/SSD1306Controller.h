@@ -0,0 +1,71 @@
+// SSD1306Controller.h - Model of the SSD1306 controller RAM fed by the recording Wire shim
+
+#pragma once
+
+#ifndef SSD1306_CONTROLLER_H
+#  define SSD1306_CONTROLLER_H
+
+#  include <Arduino.h>
+#  include <Wire.h>
+
+#  define SSD1306_CONTROLLER_COLUMNS 128
+#  define SSD1306_CONTROLLER_PAGES 8
+
+// Register with Wire.setListener(). Decodes command and data transmissions to the panel address
+// the way the controller does in horizontal addressing mode: column/page windows (0x21/0x22),
+// auto-increment with wrap, and the one-column content scroll (0x2C/0x2D). RAM is kept in column
+// address order; segment remap and COM scan direction are recorded but only change what the panel
+// shows, not what RAM holds.
+class SSD1306Controller : public TwoWire::Listener {
+ public:
+  explicit SSD1306Controller(uint8_t address = 0x3C);
+
+  // Fills RAM with a pattern, as after power-up RAM content is undefined.
+  void reset(void);
+  void transmission(uint8_t address, const uint8_t* data, size_t length) override;
+
+  uint8_t getRam(uint8_t page, uint8_t column) const;
+  // True if the RAM window starting at column colOffset holds the page-ordered buffer.
+  bool matches(const uint8_t* buffer, uint8_t width, uint8_t height, uint8_t colOffset = 0) const;
+  bool isDisplayOn(void) const;
+  bool isSegmentRemapped(void) const;
+  bool isComScanReversed(void) const;
+
+  // Unknown commands, data outside horizontal addressing mode, and malformed transmissions.
+  unsigned long getProtocolErrors(void) const;
+  // RAM writes or scroll commands sent before the previous content scroll had time to finish.
+  unsigned long getScrollTimingErrors(void) const;
+  unsigned long getScrollCommands(void) const;
+
+ private:
+  void command(uint8_t value);
+  void execute(void);
+  void data(uint8_t value);
+  void contentScroll(bool left);
+
+  uint8_t address;
+  uint8_t ram[SSD1306_CONTROLLER_PAGES][SSD1306_CONTROLLER_COLUMNS];
+  uint8_t addressingMode;
+  uint8_t startColumn;
+  uint8_t endColumn;
+  uint8_t startPage;
+  uint8_t endPage;
+  uint8_t column;
+  uint8_t page;
+  bool displayOn;
+  bool segmentRemap;
+  bool comScanReversed;
+
+  // Command being assembled and the parameter bytes it still needs.
+  uint8_t pending[8];
+  uint8_t pendingLength;
+  uint8_t pendingNeeded;
+
+  bool scrolled;
+  unsigned long scrollTime;
+  unsigned long protocolErrors;
+  unsigned long scrollTimingErrors;
+  unsigned long scrollCommands;
+};
+
+#endif  // SSD1306_CONTROLLER_H
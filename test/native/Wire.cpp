@@ -0,0 +1,58 @@
+// Wire.cpp - Host shim of the Arduino Wire library that records I2C traffic
+
+#include "Wire.h"
+
+TwoWire::TwoWire() : listener(nullptr), address(0), length(0), bytesWritten(0), transactions(0), overflows(0) {
+}
+
+void TwoWire::begin(void) {
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+  this->address = address;
+  length = 0;
+}
+
+size_t TwoWire::write(uint8_t value) {
+  if (length >= BUFFER_LENGTH) {
+    overflows++;
+    return 0;
+  }
+  buffer[length++] = value;
+  bytesWritten++;
+  return 1;
+}
+
+uint8_t TwoWire::endTransmission(bool stop) {
+  (void)stop;
+  transactions++;
+  if (listener != nullptr) {
+    listener->transmission(address, buffer, length);
+  }
+  length = 0;
+  return 0;
+}
+
+void TwoWire::setListener(Listener* listener) {
+  this->listener = listener;
+}
+
+void TwoWire::resetCounters(void) {
+  bytesWritten = 0;
+  transactions = 0;
+  overflows = 0;
+}
+
+unsigned long TwoWire::getBytesWritten(void) const {
+  return bytesWritten;
+}
+
+unsigned long TwoWire::getTransactions(void) const {
+  return transactions;
+}
+
+unsigned long TwoWire::getOverflows(void) const {
+  return overflows;
+}
+
+TwoWire Wire;
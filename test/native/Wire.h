@@ -0,0 +1,51 @@
+// Wire.h - Host shim of the Arduino Wire library that records I2C traffic
+
+#pragma once
+
+#ifndef WIRE_H
+#  define WIRE_H
+
+#  include <Arduino.h>
+
+#  ifndef BUFFER_LENGTH
+#    define BUFFER_LENGTH 32
+#  endif
+
+class TwoWire {
+ public:
+  // Receives every transmission that endTransmission() completes.
+  class Listener {
+   public:
+    virtual ~Listener() {
+    }
+    virtual void transmission(uint8_t address, const uint8_t* data, size_t length) = 0;
+  };
+
+  TwoWire();
+
+  void begin(void);
+  void beginTransmission(uint8_t address);
+  size_t write(uint8_t value);
+  uint8_t endTransmission(bool stop = true);
+
+  void setListener(Listener* listener);
+  void resetCounters(void);
+  // Bytes passed to write() (address bytes excluded), and completed transmissions.
+  unsigned long getBytesWritten(void) const;
+  unsigned long getTransactions(void) const;
+  // Writes beyond BUFFER_LENGTH, which the real library drops.
+  unsigned long getOverflows(void) const;
+
+ private:
+  Listener* listener;
+  uint8_t address;
+  uint8_t buffer[BUFFER_LENGTH];
+  size_t length;
+  unsigned long bytesWritten;
+  unsigned long transactions;
+  unsigned long overflows;
+};
+
+extern TwoWire Wire;
+
+#endif  // WIRE_H
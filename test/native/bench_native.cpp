@@ -0,0 +1,566 @@
+// bench_native.cpp - Host benchmarks of the render and driver hot paths (see `make bench/native`)
+//
+// Prints one CSV row per hot path and writes the same rows to the file named on the command line:
+//
+//   name,iterations,ns_per_op,i2c_bytes_per_op,i2c_transactions_per_op
+//
+// Times are host nanoseconds, useful to compare implementations rather than to predict the
+// CH32V003; I2C figures come from the recording Wire shim and match the target exactly.
+
+#include <stdio.h>
+
+#include <chrono>
+#include <vector>
+
+#include "ChartScale.h"
+#include "Model.h"
+#include "SSD1306.h"
+#include "SensorDataHistory.h"
+#include "SensorDataTrend.h"
+#include "View.h"
+
+#define BENCH_WIDTH 128
+#define BENCH_HEIGHT 32
+#define BENCH_BUFFER_SIZE (BENCH_WIDTH * BENCH_HEIGHT / 8)
+#define BENCH_STEP 3
+#define BENCH_HISTORY_SIZE ((BENCH_WIDTH + BENCH_STEP - 1) / BENCH_STEP + 1)
+#define BENCH_TREND_SIZE 24
+#define BENCH_ITERATIONS 10000
+#define BENCH_SAMPLES 256
+
+static uint8_t displayBuffer[BENCH_BUFFER_SIZE];
+static uint8_t displayShadowBuffer[BENCH_BUFFER_SIZE];
+static int16_t historyBuffer[BENCH_HISTORY_SIZE];
+static uint16_t historyMinIndexBuffer[BENCH_HISTORY_SIZE];
+static uint16_t historyMaxIndexBuffer[BENCH_HISTORY_SIZE];
+static SensorDataTrend::Bucket trendBuffer[SensorDataTrend::TIER_COUNT * BENCH_TREND_SIZE];
+
+static SSD1306 display(BENCH_WIDTH, BENCH_HEIGHT, displayBuffer, &Wire, displayShadowBuffer);
+static SensorDataHistory history(historyBuffer, BENCH_HISTORY_SIZE, historyMinIndexBuffer, historyMaxIndexBuffer);
+static SensorDataTrend trend(trendBuffer, BENCH_TREND_SIZE);
+static Model model(&history, &trend, 1);
+static View view(model, display, BENCH_STEP);
+
+static FILE* output = nullptr;
+// Results are folded in here so the optimizer keeps the measured work.
+static volatile int32_t sink;
+
+static uint64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void report(const char* name, unsigned long iterations, uint64_t elapsedNs) {
+  char row[128];
+  snprintf(row, sizeof(row), "%s,%lu,%.1f,%.1f,%.2f\n", name, iterations, (double)elapsedNs / iterations, (double)Wire.getBytesWritten() / iterations, (double)Wire.getTransactions() / iterations);
+  fputs(row, stdout);
+  if (output != nullptr) {
+    fputs(row, output);
+  }
+}
+
+// Time only moves when something reads the clock, so step it between updates: the content scroll
+// waits for the controller on millis().
+static void finishFlush(SSD1306& target = display) {
+  while (target.update()) {
+    advanceMicros(1000);
+  }
+}
+
+// Same synthetic wave as the on-target benchmark.
+static int16_t nextSample(int16_t& value, int16_t& slope, size_t i) {
+  if (value > 2600 || value < 1800) {
+    slope = -slope;
+  }
+  value += slope + static_cast<int16_t>(i * 37 % 11) - 5;
+  return value;
+}
+
+static void fillModel(size_t count) {
+  Model::SensorData data = {};
+  data.channelCount = 1;
+  data.resolution = 12;
+  int16_t value = 2000;
+  int16_t slope = 7;
+  for (size_t i = 0; i < count; i++) {
+    data.temperature[0] = nextSample(value, slope, i);
+    model.update(data);
+    delay(3000);
+  }
+}
+
+// getMinMaxValue() on a full history: over every value from the index buffers, over one value
+// less (which scans), and scanning without index buffers.
+static void benchMinMax() {
+  static const size_t sizes[] = {BENCH_HISTORY_SIZE, 512, 4096};
+  char name[64];
+  int16_t minValue, maxValue;
+  for (size_t size : sizes) {
+    std::vector<int16_t> values(size);
+    std::vector<uint16_t> minIndices(size);
+    std::vector<uint16_t> maxIndices(size);
+    int16_t value = 2000;
+    int16_t slope = 7;
+
+    for (int tracked = 1; tracked >= 0; tracked--) {
+      SensorDataHistory ring(values.data(), size, tracked ? minIndices.data() : nullptr, tracked ? maxIndices.data() : nullptr);
+      ring.begin();
+      for (size_t i = 0; i < size; i++) {
+        ring.prepend(nextSample(value, slope, i));
+      }
+      const size_t windows[] = {size, size - 1};
+      for (size_t w = 0; w < (tracked ? 2u : 1u); w++) {
+        uint64_t start = nowNs();
+        for (unsigned long i = 0; i < BENCH_ITERATIONS; i++) {
+          ring.getMinMaxValue(windows[w], minValue, maxValue);
+          sink += minValue + maxValue;
+        }
+        uint64_t elapsed = nowNs() - start;
+        snprintf(name, sizeof(name), "getMinMaxValue/%s/%zu", !tracked ? "scan" : (w == 0 ? "minmax" : "minmax_partial"), size);
+        report(name, BENCH_ITERATIONS, elapsed);
+      }
+    }
+  }
+}
+
+// The shifting prepend SensorDataHistory used before its ring buffer, as a baseline.
+static void shiftPrepend(int16_t* buffer, size_t size, size_t& count, int16_t value) {
+  for (size_t i = (count == size ? size - 1 : count); i > 0; i--) {
+    buffer[i] = buffer[i - 1];
+  }
+  buffer[0] = value;
+  if (count < size) count++;
+}
+
+// Steady-state prepend on a full history, with the old shift, the ring buffer, and the ring buffer
+// with min/max index buffers.
+static void benchPrepend() {
+  static const size_t sizes[] = {44, 512, 4096};
+  char name[48];
+  for (size_t size : sizes) {
+    std::vector<int16_t> values(size);
+    std::vector<uint16_t> minIndices(size);
+    std::vector<uint16_t> maxIndices(size);
+    int16_t value = 2000;
+    int16_t slope = 7;
+
+    size_t count = 0;
+    for (size_t i = 0; i < size; i++) {
+      shiftPrepend(values.data(), size, count, nextSample(value, slope, i));
+    }
+    Wire.resetCounters();
+    uint64_t start = nowNs();
+    for (unsigned long i = 0; i < BENCH_ITERATIONS; i++) {
+      shiftPrepend(values.data(), size, count, nextSample(value, slope, i));
+    }
+    uint64_t elapsed = nowNs() - start;
+    sink += values[size / 2];
+    snprintf(name, sizeof(name), "prepend/shift/%zu", size);
+    report(name, BENCH_ITERATIONS, elapsed);
+
+    for (int tracked = 0; tracked < 2; tracked++) {
+      SensorDataHistory ring(values.data(), size, tracked ? minIndices.data() : nullptr, tracked ? maxIndices.data() : nullptr);
+      ring.begin();
+      for (size_t i = 0; i < size; i++) {
+        ring.prepend(nextSample(value, slope, i));
+      }
+      start = nowNs();
+      for (unsigned long i = 0; i < BENCH_ITERATIONS; i++) {
+        ring.prepend(nextSample(value, slope, i));
+      }
+      elapsed = nowNs() - start;
+      sink += ring.getValue(size / 2);
+      snprintf(name, sizeof(name), tracked ? "prepend/ring_minmax/%zu" : "prepend/ring/%zu", size);
+      report(name, BENCH_ITERATIONS, elapsed);
+    }
+  }
+}
+
+// Maps random chart data to rows with the reciprocal and with the division per value it replaced.
+// On the host the divide instruction is cheap; on RV32EC each division is a libgcc call.
+static void benchChartScale() {
+  const size_t count = 4096;
+  std::vector<int16_t> values(count);
+  std::vector<int16_t> ranges(count / 64);
+  srand(25);
+  for (size_t i = 0; i < ranges.size(); i++) {
+    ranges[i] = 1 + rand() % 3000;
+  }
+  for (size_t i = 0; i < count; i++) {
+    values[i] = 2000 - rand() % (ranges[i / 64] + 1);
+  }
+
+  const int16_t chartY = 16;
+  const int16_t chartH = 16;
+  Wire.resetCounters();
+  uint64_t start = nowNs();
+  for (unsigned long i = 0; i < BENCH_ITERATIONS; i++) {
+    int32_t sum = 0;
+    for (size_t block = 0; block < ranges.size(); block++) {
+      uint16_t range = ranges[block];
+      for (size_t j = block * 64; j < block * 64 + 64; j++) {
+        sum += chartY + (int16_t)((int32_t)(2000 - values[j]) * (chartH - 1) / range);
+      }
+    }
+    sink += sum;
+  }
+  report("chart_scale/divide", BENCH_ITERATIONS * count, nowNs() - start);
+
+  start = nowNs();
+  for (unsigned long i = 0; i < BENCH_ITERATIONS; i++) {
+    int32_t sum = 0;
+    for (size_t block = 0; block < ranges.size(); block++) {
+      ChartScale scale = makeChartScale(2000, ranges[block], chartY, chartH);
+      for (size_t j = block * 64; j < block * 64 + 64; j++) {
+        sum += scaleToChartY(scale, values[j]);
+      }
+    }
+    sink += sum;
+  }
+  report("chart_scale/reciprocal", BENCH_ITERATIONS * count, nowNs() - start);
+}
+
+// drawLine() as it was before the column-run rasterizer (user-004 dirty tracking included), with
+// its own dirty and ink ranges so the comparison does the same bookkeeping.
+class LegacyLines {
+ public:
+  LegacyLines(uint8_t* buffer) : buffer(buffer) {
+    for (uint8_t page = 0; page < BENCH_HEIGHT / 8; page++) {
+      dirtyMin[page] = inkMin[page] = 0xFF;
+      dirtyMax[page] = inkMax[page] = 0;
+    }
+  }
+
+  void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t color) {
+    int16_t dx = abs(x1 - x0);
+    int16_t dy = abs(y1 - y0);
+    int8_t sx = x0 < x1 ? 1 : -1;
+    int8_t sy = y0 < y1 ? 1 : -1;
+
+    if (dx == 0) {
+      drawVLine(x0, y0 < y1 ? y0 : y1, dy + 1, color);
+      return;
+    }
+    if (dy == 0) {
+      drawHLine(x0 < x1 ? x0 : x1, y0, dx + 1, color);
+      return;
+    }
+    if (dx == dy) {
+      markDirty(x0 < x1 ? x0 : x1, y0 < y1 ? y0 : y1, x0 < x1 ? x1 : x0, y0 < y1 ? y1 : y0);
+      for (int16_t i = 0; i <= dx; i++) {
+        drawPixel(x0, y0, color);
+        x0 += sx;
+        y0 += sy;
+      }
+      return;
+    }
+
+    markDirty(x0 < x1 ? x0 : x1, y0 < y1 ? y0 : y1, x0 < x1 ? x1 : x0, y0 < y1 ? y1 : y0);
+    int16_t err = dx - dy;
+    while (true) {
+      drawPixel(x0, y0, color);
+      if (x0 == x1 && y0 == y1) {
+        break;
+      }
+      int16_t e2 = err * 2;
+      if (e2 > -dy) {
+        err -= dy;
+        x0 += sx;
+      }
+      if (e2 < dx) {
+        err += dx;
+        y0 += sy;
+      }
+    }
+  }
+
+ private:
+  void drawPixel(int16_t x, int16_t y, uint8_t color) {
+    if (x >= 0 && x < BENCH_WIDTH && y >= 0 && y < BENCH_HEIGHT) {
+      uint16_t idx = x + (y / 8) * BENCH_WIDTH;
+      uint8_t bit = 1 << (y & 7);
+      if (color == SSD1306_WHITE) {
+        buffer[idx] |= bit;
+      } else {
+        buffer[idx] &= ~bit;
+      }
+    }
+  }
+
+  void drawVLine(int16_t x, int16_t y, int16_t h, uint8_t color) {
+    if (x < 0 || x >= BENCH_WIDTH) return;
+    int16_t y1 = y + h - 1;
+    if (y1 < 0 || y >= BENCH_HEIGHT) return;
+    if (y < 0) y = 0;
+    if (y1 >= BENCH_HEIGHT) y1 = BENCH_HEIGHT - 1;
+    markDirty(x, y, x, y1);
+    for (int16_t yy = y; yy <= y1; yy++) {
+      drawPixel(x, yy, color);
+    }
+  }
+
+  void drawHLine(int16_t x, int16_t y, int16_t w, uint8_t color) {
+    if (y < 0 || y >= BENCH_HEIGHT) return;
+    int16_t x1 = x + w - 1;
+    if (x1 < 0 || x >= BENCH_WIDTH) return;
+    if (x < 0) x = 0;
+    if (x1 >= BENCH_WIDTH) x1 = BENCH_WIDTH - 1;
+    markDirty(x, y, x1, y);
+    for (int16_t xx = x; xx <= x1; xx++) {
+      drawPixel(xx, y, color);
+    }
+  }
+
+  void markDirty(int16_t x0, int16_t y0, int16_t x1, int16_t y1) {
+    if (x1 < 0 || y1 < 0 || x0 >= BENCH_WIDTH || y0 >= BENCH_HEIGHT) return;
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 >= BENCH_WIDTH) x1 = BENCH_WIDTH - 1;
+    if (y1 >= BENCH_HEIGHT) y1 = BENCH_HEIGHT - 1;
+    for (uint8_t page = y0 / 8; page <= y1 / 8; page++) {
+      if (x0 < dirtyMin[page]) dirtyMin[page] = x0;
+      if (x1 > dirtyMax[page]) dirtyMax[page] = x1;
+      if (x0 < inkMin[page]) inkMin[page] = x0;
+      if (x1 > inkMax[page]) inkMax[page] = x1;
+    }
+  }
+
+  uint8_t* buffer;
+  uint8_t dirtyMin[BENCH_HEIGHT / 8];
+  uint8_t dirtyMax[BENCH_HEIGHT / 8];
+  uint8_t inkMin[BENCH_HEIGHT / 8];
+  uint8_t inkMax[BENCH_HEIGHT / 8];
+};
+
+// Lines across the whole area, alternating shallow and steep, then the same lines stretched so
+// both ends lie off screen; each with the legacy rasterizer and with drawLine().
+static void benchDrawLine() {
+  static const char* const names[] = {"drawLine/legacy", "drawLine", "drawLine/clipped_legacy", "drawLine/clipped"};
+  for (int run = 0; run < 4; run++) {
+    LegacyLines legacy(displayBuffer);
+    int16_t reach = (run < 2) ? 0 : 40;
+    display.clearDisplay();
+    Wire.resetCounters();
+    uint64_t start = nowNs();
+    for (unsigned long i = 0; i < BENCH_ITERATIONS; i++) {
+      int16_t y = i % BENCH_HEIGHT;
+      int16_t x = i % BENCH_WIDTH;
+      if (run & 1) {
+        display.drawLine(-reach, y - reach, BENCH_WIDTH - 1 + reach, BENCH_HEIGHT - 1 - y + reach);
+        display.drawLine(x - reach, -reach, BENCH_WIDTH - 1 - x + reach, BENCH_HEIGHT - 1 + reach);
+      } else {
+        legacy.drawLine(-reach, y - reach, BENCH_WIDTH - 1 + reach, BENCH_HEIGHT - 1 - y + reach, SSD1306_WHITE);
+        legacy.drawLine(x - reach, -reach, BENCH_WIDTH - 1 - x + reach, BENCH_HEIGHT - 1 + reach, SSD1306_WHITE);
+      }
+    }
+    sink += displayBuffer[BENCH_WIDTH * 2];
+    report(names[run], BENCH_ITERATIONS * 2, nowNs() - start);
+  }
+}
+
+// Random chart polylines in the 16-row chart area, one segment per BENCH_STEP columns. As in the
+// view, the oldest point lies left of the screen, so the first segment is clipped.
+static void benchChartLines() {
+  const size_t points = BENCH_HISTORY_SIZE;
+  const size_t charts = 64;
+  std::vector<int16_t> ys(charts * points);
+  srand(18);
+  for (size_t i = 0; i < ys.size(); i++) {
+    ys[i] = 16 + rand() % 16;
+  }
+
+  LegacyLines legacy(displayBuffer);
+  display.clearDisplay();
+  Wire.resetCounters();
+  uint64_t start = nowNs();
+  for (unsigned long i = 0; i < BENCH_ITERATIONS / 10; i++) {
+    const int16_t* y = &ys[(i % charts) * points];
+    for (size_t j = 0; j + 1 < points; j++) {
+      legacy.drawLine(j * BENCH_STEP - 2, y[j], (j + 1) * BENCH_STEP - 2, y[j + 1], SSD1306_WHITE);
+    }
+  }
+  sink += displayBuffer[BENCH_WIDTH * 3];
+  report("drawLine/chart_legacy", (BENCH_ITERATIONS / 10) * (points - 1), nowNs() - start);
+
+  display.clearDisplay();
+  start = nowNs();
+  for (unsigned long i = 0; i < BENCH_ITERATIONS / 10; i++) {
+    const int16_t* y = &ys[(i % charts) * points];
+    for (size_t j = 0; j + 1 < points; j++) {
+      display.drawLine(j * BENCH_STEP - 2, y[j], (j + 1) * BENCH_STEP - 2, y[j + 1]);
+    }
+  }
+  sink += displayBuffer[BENCH_WIDTH * 3];
+  report("drawLine/chart", (BENCH_ITERATIONS / 10) * (points - 1), nowNs() - start);
+}
+
+static void benchDrawChar() {
+  display.clearDisplay();
+  display.setTextColor(SSD1306_WHITE, SSD1306_BLACK);
+  Wire.resetCounters();
+  uint64_t start = nowNs();
+  for (unsigned long i = 0; i < BENCH_ITERATIONS; i++) {
+    display.setTextSize(1 + i % 3);
+    display.drawChar(0, 0, '0' + i % 10, SSD1306_WHITE);
+  }
+  report("drawChar", BENCH_ITERATIONS, nowNs() - start);
+}
+
+static void benchDisplay() {
+  display.clearDisplay();
+  finishFlush();
+  Wire.resetCounters();
+  uint64_t start = nowNs();
+  for (unsigned long i = 0; i < BENCH_ITERATIONS; i++) {
+    display.drawPixel(i % BENCH_WIDTH, (i / BENCH_WIDTH) % BENCH_HEIGHT, ((i / (BENCH_WIDTH * BENCH_HEIGHT)) & 1) ? SSD1306_BLACK : SSD1306_WHITE);
+    display.display();
+  }
+  report("display", BENCH_ITERATIONS, nowNs() - start);
+}
+
+// render() only draws and starts the transfer; the flush is included so the I2C columns show the
+// traffic of a forced redraw in each mode.
+static void benchRender() {
+  for (uint8_t mode = 0; mode < View::VIEW_MODE_COUNT; mode++) {
+    static const char* const names[View::VIEW_MODE_COUNT] = {
+      "render/chart", "render/chart_minute", "render/chart_hour", "render/chart_day", "render/text",
+    };
+    view.setViewMode(static_cast<View::ViewMode>(mode));
+    view.render();
+    finishFlush();
+
+    Wire.resetCounters();
+    uint64_t start = nowNs();
+    for (unsigned long i = 0; i < BENCH_ITERATIONS; i++) {
+      view.invalidate();
+      view.render();
+      finishFlush();
+    }
+    report(names[mode], BENCH_ITERATIONS, nowNs() - start);
+  }
+  view.setViewMode(View::VIEW_MODE_CHART);
+}
+
+// The transfer the driver made for every frame before dirty tracking: the window as six single
+// command transactions, then the whole buffer in 16-byte data transactions.
+static void fullBufferFrame() {
+  const uint8_t window[] = {0x21, 0, BENCH_WIDTH - 1, 0x22, 0, BENCH_HEIGHT / 8 - 1};
+  for (uint8_t cmd : window) {
+    Wire.beginTransmission(0x3C);
+    Wire.write(0x00);
+    Wire.write(cmd);
+    Wire.endTransmission();
+  }
+  for (uint16_t i = 0; i < BENCH_BUFFER_SIZE; i += 16) {
+    Wire.beginTransmission(0x3C);
+    Wire.write(0x40);
+    for (uint16_t j = i; j < i + 16 && j < BENCH_BUFFER_SIZE; j++) {
+      Wire.write(displayBuffer[j]);
+    }
+    Wire.endTransmission();
+  }
+}
+
+// One typical frame per op: a new reading that changes only the last digit of the text view, a
+// new reading that steps the chart one sample, and a full redraw after a view mode switch. Each
+// runs without a shadow buffer, with one, and with one plus the controller's content scroll.
+static void benchFrames() {
+  static const size_t frames = BENCH_ITERATIONS / 10;
+  Model::SensorData data = {};
+  data.channelCount = 1;
+  data.resolution = 12;
+
+  Wire.resetCounters();
+  uint64_t start = nowNs();
+  for (size_t i = 0; i < frames; i++) {
+    fullBufferFrame();
+  }
+  report("frame/full_buffer", frames, nowNs() - start);
+
+  static const char* const configs[] = {"plain", "shadow", "shadow_scroll"};
+  for (uint8_t config = 0; config < 3; config++) {
+    static uint8_t buffer[BENCH_BUFFER_SIZE];
+    static uint8_t shadowBuffer[BENCH_BUFFER_SIZE];
+    SSD1306 frameDisplay(BENCH_WIDTH, BENCH_HEIGHT, buffer, &Wire, config > 0 ? shadowBuffer : nullptr);
+    View frameView(model, frameDisplay, BENCH_STEP);
+    frameView.begin();
+    frameDisplay.setHardwareScroll(config == 2);
+    char name[48];
+
+    frameView.setViewMode(View::VIEW_MODE_TEXT);
+    frameView.render();
+    finishFlush(frameDisplay);
+    Wire.resetCounters();
+    start = nowNs();
+    for (size_t i = 0; i < frames; i++) {
+      data.temperature[0] = (i & 1) ? 2010 : 2000;
+      model.update(data);
+      frameView.render();
+      finishFlush(frameDisplay);
+    }
+    snprintf(name, sizeof(name), "frame/%s/digit", configs[config]);
+    report(name, frames, nowNs() - start);
+
+    frameView.setViewMode(View::VIEW_MODE_CHART);
+    frameView.render();
+    finishFlush(frameDisplay);
+    int16_t value = 2000;
+    int16_t slope = 7;
+    Wire.resetCounters();
+    start = nowNs();
+    for (size_t i = 0; i < frames; i++) {
+      data.temperature[0] = nextSample(value, slope, i);
+      model.update(data);
+      frameView.render();
+      finishFlush(frameDisplay);
+    }
+    snprintf(name, sizeof(name), "frame/%s/chart_step", configs[config]);
+    report(name, frames, nowNs() - start);
+
+    Wire.resetCounters();
+    start = nowNs();
+    for (size_t i = 0; i < frames; i++) {
+      frameView.setViewMode((i & 1) ? View::VIEW_MODE_CHART : View::VIEW_MODE_TEXT);
+      frameView.render();
+      finishFlush(frameDisplay);
+    }
+    snprintf(name, sizeof(name), "frame/%s/full", configs[config]);
+    report(name, frames, nowNs() - start);
+  }
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1) {
+    output = fopen(argv[1], "w");
+    if (output == nullptr) {
+      perror(argv[1]);
+      return 1;
+    }
+  }
+
+  const char* header = "name,iterations,ns_per_op,i2c_bytes_per_op,i2c_transactions_per_op\n";
+  fputs(header, stdout);
+  if (output != nullptr) {
+    fputs(header, output);
+  }
+
+  view.begin();
+  history.begin();
+  trend.begin();
+  fillModel(BENCH_SAMPLES);
+  finishFlush();
+
+  benchPrepend();
+  benchMinMax();
+  benchChartScale();
+  benchDrawLine();
+  benchChartLines();
+  benchDrawChar();
+  benchDisplay();
+  benchRender();
+  benchFrames();
+
+  if (output != nullptr) {
+    fclose(output);
+  }
+  return 0;
+}
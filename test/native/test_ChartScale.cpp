@@ -0,0 +1,89 @@
+// test_ChartScale.cpp - Exactness of the chart row mapping against integer division
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "ChartScale.h"
+
+#define TEST_CHART_Y 3
+#define TEST_MAX_VALUE 16000
+#define TEST_MAX_HEIGHT 112
+#define TEST_MAX_RANGE 32767
+
+static int16_t divideToChartY(int16_t chartH, uint16_t range, uint16_t offset) {
+  return TEST_CHART_Y + (int16_t)(((uint32_t)offset * (chartH - 1)) / range);
+}
+
+// Counts mismatches and reports the first one, which keeps the exhaustive loops fast.
+class ExactnessCheck {
+ public:
+  ExactnessCheck() : mismatches(0) {
+  }
+
+  ~ExactnessCheck() {
+    EXPECT_EQ(0ul, mismatches) << "first mismatch: " << first;
+  }
+
+  void check(const ChartScale& scale, uint16_t offset) {
+    int16_t expected = divideToChartY(scale.chartH, scale.range, offset);
+    int16_t actual = scaleToChartY(scale, (int16_t)(TEST_MAX_VALUE - offset));
+    if (expected != actual && mismatches++ == 0) {
+      first = "height " + std::to_string(scale.chartH) + " range " + std::to_string(scale.range) + " offset " + std::to_string(offset) + ": " + std::to_string(actual) + " instead of " + std::to_string(expected);
+    }
+  }
+
+ private:
+  unsigned long mismatches;
+  std::string first;
+};
+
+TEST(ChartScaleTest, ZeroRangeCentersValues) {
+  for (int16_t chartH = 1; chartH <= TEST_MAX_HEIGHT; chartH++) {
+    ChartScale scale = makeChartScale(TEST_MAX_VALUE, 0, TEST_CHART_Y, chartH);
+    EXPECT_EQ(TEST_CHART_Y + chartH / 2, scaleToChartY(scale, TEST_MAX_VALUE));
+  }
+}
+
+TEST(ChartScaleTest, ExactForEveryOffsetOfSmallRanges) {
+  ExactnessCheck exactness;
+  for (int16_t chartH = 1; chartH <= TEST_MAX_HEIGHT; chartH++) {
+    for (uint16_t range = 1; range <= 300; range++) {
+      ChartScale scale = makeChartScale(TEST_MAX_VALUE, (int16_t)range, TEST_CHART_Y, chartH);
+      for (uint16_t offset = 0; offset <= range; offset++) {
+        exactness.check(scale, offset);
+      }
+    }
+  }
+}
+
+// Rounding can only go wrong next to a row boundary, so checking both sides of every boundary
+// covers all offsets of a range. Every range up to 4096 is checked, then a stride of 13 up to
+// the largest range.
+TEST(ChartScaleTest, ExactAtEveryRowBoundary) {
+  ExactnessCheck exactness;
+  for (int16_t chartH = 1; chartH <= TEST_MAX_HEIGHT; chartH++) {
+    for (uint32_t range = 1; range <= TEST_MAX_RANGE; range += (range < 4096 || range > TEST_MAX_RANGE - 13) ? 1 : 13) {
+      ChartScale scale = makeChartScale(TEST_MAX_VALUE, (int16_t)range, TEST_CHART_Y, chartH);
+      exactness.check(scale, 0);
+      exactness.check(scale, range);
+      for (uint32_t row = 1; row < (uint32_t)chartH - 1; row++) {
+        // First offset that maps to `row`.
+        uint32_t offset = (row * range + chartH - 2) / (chartH - 1);
+        exactness.check(scale, offset);
+        exactness.check(scale, offset - 1);
+      }
+    }
+  }
+}
+
+TEST(ChartScaleTest, ExactForRandomValues) {
+  ExactnessCheck exactness;
+  srand(25);
+  for (int i = 0; i < 2000000; i++) {
+    int16_t chartH = 1 + rand() % TEST_MAX_HEIGHT;
+    uint16_t range = 1 + rand() % TEST_MAX_RANGE;
+    ChartScale scale = makeChartScale(TEST_MAX_VALUE, (int16_t)range, TEST_CHART_Y, chartH);
+    exactness.check(scale, rand() % (range + 1));
+  }
+}
@@ -0,0 +1,241 @@
+// test_DS18B20.cpp - DS18B20 driver tests against the simulated bus
+
+#include <gtest/gtest.h>
+
+#include "DS18B20.h"
+#include "DS18B20Bus.h"
+#include "OneWire.h"
+
+#define TEST_PIN PC5
+
+class DS18B20Test : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    resetPins();
+    setMicros(0);
+    attachPinModel(TEST_PIN, &bus);
+  }
+
+  void TearDown() override {
+    attachPinModel(TEST_PIN, nullptr);
+  }
+
+  uint8_t addDevice(uint32_t serial, bool parasite = false) {
+    uint8_t rom[8];
+    DS18B20Bus::makeRom(serial, rom);
+    return bus.addDevice(rom, parasite);
+  }
+
+  void convert(DS18B20& sensor) {
+    sensor.requestTemparature();
+    delay(sensor.getConversionTimeMs());
+  }
+
+  DS18B20Bus bus;
+};
+
+TEST_F(DS18B20Test, BeginWritesResolution) {
+  addDevice(1);
+  OneWire wire(TEST_PIN, true);
+  DS18B20 sensor(wire, 0, 10);
+  sensor.begin();
+
+  EXPECT_EQ(10, bus.getResolution(0));
+  EXPECT_EQ(10, sensor.getResolution());
+  EXPECT_EQ(188u, sensor.getConversionTimeMs());
+  EXPECT_EQ(1, sensor.getDeviceCount());
+}
+
+TEST_F(DS18B20Test, DetectsPowerSupply) {
+  addDevice(1, true);
+  OneWire wire(TEST_PIN, true);
+  DS18B20 sensor(wire);
+  sensor.begin();
+  EXPECT_TRUE(sensor.isParasitePowered());
+
+  DS18B20Bus externalBus;
+  uint8_t rom[8];
+  DS18B20Bus::makeRom(2, rom);
+  externalBus.addDevice(rom, false);
+  attachPinModel(TEST_PIN, &externalBus);
+  sensor.begin();
+  EXPECT_FALSE(sensor.isParasitePowered());
+}
+
+TEST_F(DS18B20Test, ReadsConvertedTemperature) {
+  addDevice(1);
+  OneWire wire(TEST_PIN, true);
+  DS18B20 sensor(wire, -90);
+  sensor.begin();
+
+  bus.setTemperature(0, 0x0191);  // 25.0625 degC
+  convert(sensor);
+  int16_t temperature = 0;
+  ASSERT_TRUE(sensor.readTemparature(temperature));
+  EXPECT_EQ(2506 - 90, temperature);
+
+  bus.setTemperature(0, (int16_t)0xFE6F);  // -25.0625 degC
+  convert(sensor);
+  ASSERT_TRUE(sensor.readTemparature(temperature));
+  EXPECT_EQ(-2506 - 90, temperature);
+}
+
+TEST_F(DS18B20Test, MasksUndefinedBitsBelowTwelveBits) {
+  addDevice(1);
+  OneWire wire(TEST_PIN, true);
+  DS18B20 sensor(wire, 0, 9);
+  sensor.begin();
+
+  bus.setTemperature(0, 0x0197);  // low three bits are undefined at 9 bits
+  convert(sensor);
+  int16_t temperature = 0;
+  ASSERT_TRUE(sensor.readTemparature(temperature));
+  EXPECT_EQ((0x0190 * 100) / 16, temperature);
+}
+
+TEST_F(DS18B20Test, AddsOffsetAfterSnappingToResolution) {
+  addDevice(1);
+  OneWire wire(TEST_PIN, true);
+  DS18B20 sensor(wire, 37, 9);
+  sensor.begin();
+
+  bus.setTemperature(0, 0x0197);  // 25.4375 degC, 25.0 at 9 bits
+  convert(sensor);
+  int16_t temperature = 0;
+  ASSERT_TRUE(sensor.readTemparature(temperature));
+  EXPECT_EQ(2500 + 37, temperature);
+}
+
+TEST_F(DS18B20Test, ConversionCompletesAfterConversionTime) {
+  addDevice(1);
+  OneWire wire(TEST_PIN, true);
+  DS18B20 sensor(wire, 0, 11);
+  sensor.begin();
+
+  sensor.requestTemparature();
+  EXPECT_FALSE(sensor.isConversionComplete());
+  delay(sensor.getConversionTimeMs() / 2);
+  EXPECT_FALSE(sensor.isConversionComplete());
+  delay(sensor.getConversionTimeMs() / 2 + 1);
+  EXPECT_TRUE(sensor.isConversionComplete());
+}
+
+TEST_F(DS18B20Test, VerifiedReadRejectsCorruptScratchpad) {
+  addDevice(1);
+  OneWire wire(TEST_PIN, true);
+  DS18B20 sensor(wire);
+  sensor.begin();
+
+  convert(sensor);
+  bus.setCorruptScratchpad(0, true);
+  int16_t temperature = 0;
+  EXPECT_FALSE(sensor.readTemparature(temperature));
+
+  sensor.setReadMode(DS18B20::READ_MODE_FAST);
+  EXPECT_TRUE(sensor.readTemparature(temperature));
+}
+
+TEST_F(DS18B20Test, FailsWithoutPresencePulse) {
+  OneWire wire(TEST_PIN, true);
+  DS18B20 sensor(wire);
+  sensor.begin();
+
+  int16_t temperature = 0;
+  EXPECT_FALSE(sensor.readTemparature(temperature));
+}
+
+TEST_F(DS18B20Test, FastReadUsesFewerSlots) {
+  addDevice(1);
+  OneWire wire(TEST_PIN, true);
+  DS18B20 sensor(wire);
+  sensor.begin();
+  bus.setTemperature(0, 0x0150);
+  convert(sensor);
+
+  int16_t verified = 0;
+  ASSERT_TRUE(sensor.readTemparature(verified));
+  EXPECT_EQ(8 + 8 + 72, sensor.getLastReadSlots());
+
+  sensor.setReadMode(DS18B20::READ_MODE_FAST);
+  int16_t fast = 0;
+  ASSERT_TRUE(sensor.readTemparature(fast));
+  EXPECT_EQ(8 + 8 + 16, sensor.getLastReadSlots());
+  EXPECT_EQ(verified, fast);
+}
+
+TEST_F(DS18B20Test, ReadsEachDeviceByRom) {
+  static const int16_t raws[] = {0x0010, 0x0200, (int16_t)0xFF80};
+  for (uint8_t i = 0; i < 3; i++) {
+    addDevice(0x100 + i * 0x35);
+    bus.setTemperature(i, raws[i]);
+  }
+
+  OneWire wire(TEST_PIN, true);
+  DS18B20 sensor(wire);
+  sensor.begin();
+  ASSERT_EQ(3, sensor.getDeviceCount());
+  convert(sensor);
+
+  // Discovery order follows the ROM search, so match readings as a set.
+  bool seen[3] = {};
+  for (uint8_t index = 0; index < 3; index++) {
+    int16_t temperature = 0;
+    ASSERT_TRUE(sensor.readTemparature(temperature, index));
+    EXPECT_EQ(8 + 64 + 8 + 72, sensor.getLastReadSlots());
+    for (uint8_t i = 0; i < 3; i++) {
+      if (temperature == (raws[i] * 100) / 16) {
+        EXPECT_FALSE(seen[i]);
+        seen[i] = true;
+      }
+    }
+  }
+  EXPECT_TRUE(seen[0] && seen[1] && seen[2]);
+
+  int16_t temperature = 0;
+  EXPECT_FALSE(sensor.readTemparature(temperature, 3));
+}
+
+// A poll call may clock one byte or one reset pulse at most, well under a millisecond of bus time,
+// so the main loop keeps servicing the display in between. MATCH ROM alone used to take 72 slots.
+TEST_F(DS18B20Test, PollClocksAtMostOneByte) {
+  static const int16_t raws[] = {0x0150, (int16_t)0xFF80};
+  for (uint8_t i = 0; i < 2; i++) {
+    addDevice(0x200 + i * 0x35);
+    bus.setTemperature(i, raws[i]);
+  }
+
+  OneWire wire(TEST_PIN, true);
+  DS18B20 sensor(wire);
+  sensor.begin();
+  ASSERT_EQ(2, sensor.getDeviceCount());
+  convert(sensor);
+
+  for (int mode = 0; mode < 2; mode++) {
+    sensor.setReadMode(mode ? DS18B20::READ_MODE_FAST : DS18B20::READ_MODE_VERIFIED);
+    for (uint8_t index = 0; index < 2; index++) {
+      int16_t expected = 0;
+      ASSERT_TRUE(sensor.readTemparature(expected, index));
+
+      sensor.beginReadTemparature(index);
+      int16_t temperature = 0;
+      DS18B20::ReadStatus status;
+      unsigned long calls = 0;
+      do {
+        unsigned long slots = bus.getSlotCount();
+        unsigned long resets = bus.getResetCount();
+        unsigned long start = micros();
+        status = sensor.pollReadTemparature(temperature);
+        unsigned long callSlots = bus.getSlotCount() - slots;
+        unsigned long callResets = bus.getResetCount() - resets;
+        EXPECT_LE(callSlots, 8ul) << "mode " << mode << " call " << calls;
+        EXPECT_TRUE(callResets == 0 || (callResets == 1 && callSlots == 0)) << "mode " << mode << " call " << calls;
+        EXPECT_LT(micros() - start, 1000ul) << "mode " << mode << " call " << calls;
+        calls++;
+      } while (status == DS18B20::READ_BUSY);
+
+      ASSERT_EQ(DS18B20::READ_DONE, status);
+      EXPECT_EQ(expected, temperature);
+      EXPECT_EQ(8 + 64 + 8 + (mode ? 16 : 72), sensor.getLastReadSlots());
+    }
+  }
+}
@@ -0,0 +1,145 @@
+// test_OneWire.cpp - 1-Wire bus tests against the simulated DS18B20 bus
+
+#include <gtest/gtest.h>
+
+#include "DS18B20Bus.h"
+#include "OneWire.h"
+
+#define TEST_PIN PC5
+
+class OneWireTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    resetPins();
+    setMicros(0);
+    attachPinModel(TEST_PIN, &bus);
+  }
+
+  void TearDown() override {
+    attachPinModel(TEST_PIN, nullptr);
+  }
+
+  DS18B20Bus bus;
+};
+
+TEST(OneWireCrcTest, MatchesBitwiseReference) {
+  uint8_t data[16];
+  for (int value = 0; value < 256; value++) {
+    data[0] = (uint8_t)value;
+    EXPECT_EQ(DS18B20Bus::crc8(data, 1), OneWire::crc8(data, 1)) << "value " << value;
+  }
+
+  srand(1);
+  for (int i = 0; i < 1000; i++) {
+    uint8_t len = 1 + rand() % sizeof(data);
+    for (uint8_t j = 0; j < len; j++) {
+      data[j] = (uint8_t)rand();
+    }
+    EXPECT_EQ(DS18B20Bus::crc8(data, len), OneWire::crc8(data, len));
+  }
+}
+
+TEST(OneWireCrcTest, ValidRomChecksToZero) {
+  uint8_t rom[8];
+  DS18B20Bus::makeRom(0x123456, rom);
+  EXPECT_EQ(0, OneWire::crc8(rom, 8));
+}
+
+TEST_F(OneWireTest, ResetWithoutDevicesReportsNoPresence) {
+  OneWire wire(TEST_PIN, true);
+  wire.begin();
+  EXPECT_EQ(0, wire.reset());
+}
+
+TEST_F(OneWireTest, ResetDetectsPresencePulse) {
+  uint8_t rom[8];
+  DS18B20Bus::makeRom(1, rom);
+  bus.addDevice(rom);
+
+  OneWire wire(TEST_PIN, true);
+  wire.begin();
+  EXPECT_EQ(1, wire.reset());
+  EXPECT_EQ(1u, bus.getResetCount());
+}
+
+TEST_F(OneWireTest, BeginResetLeavesRecoveryToCaller) {
+  uint8_t rom[8];
+  DS18B20Bus::makeRom(1, rom);
+  bus.addDevice(rom);
+
+  OneWire wire(TEST_PIN, true);
+  wire.begin();
+  EXPECT_EQ(1, wire.beginReset());
+  EXPECT_FALSE(wire.isReady());
+  advanceMicros(410);
+  EXPECT_TRUE(wire.isReady());
+}
+
+TEST_F(OneWireTest, ReadRomReturnsDeviceRom) {
+  uint8_t rom[8];
+  DS18B20Bus::makeRom(0xA5C3, rom);
+  bus.addDevice(rom);
+
+  OneWire wire(TEST_PIN, true);
+  wire.begin();
+  ASSERT_EQ(1, wire.reset());
+  wire.write(0x33);
+  for (uint8_t i = 0; i < 8; i++) {
+    EXPECT_EQ(rom[i], wire.read()) << "byte " << (int)i;
+  }
+  EXPECT_EQ(8u + 64, bus.getSlotCount());
+}
+
+TEST_F(OneWireTest, SearchFindsEveryDeviceOnce) {
+  static const uint32_t serials[] = {0x000001, 0x800000, 0x123456, 0x123457, 0xFFFFFF};
+  const uint8_t deviceCount = sizeof(serials) / sizeof(serials[0]);
+  for (uint8_t i = 0; i < deviceCount; i++) {
+    uint8_t rom[8];
+    DS18B20Bus::makeRom(serials[i], rom);
+    bus.addDevice(rom);
+  }
+
+  OneWire wire(TEST_PIN, true);
+  wire.begin();
+
+  bool seen[deviceCount] = {};
+  uint8_t rom[8];
+  uint8_t found = 0;
+  while (wire.search(rom)) {
+    ASSERT_LT(found, deviceCount);
+    EXPECT_EQ(0, OneWire::crc8(rom, 8));
+    uint32_t serial = rom[1] | ((uint32_t)rom[2] << 8) | ((uint32_t)rom[3] << 16);
+    for (uint8_t i = 0; i < deviceCount; i++) {
+      if (serials[i] == serial) {
+        EXPECT_FALSE(seen[i]);
+        seen[i] = true;
+      }
+    }
+    found++;
+  }
+  EXPECT_EQ(deviceCount, found);
+  for (uint8_t i = 0; i < deviceCount; i++) {
+    EXPECT_TRUE(seen[i]) << "serial " << serials[i];
+  }
+}
+
+TEST_F(OneWireTest, SearchWithoutDevicesFindsNothing) {
+  OneWire wire(TEST_PIN, true);
+  wire.begin();
+  uint8_t rom[8];
+  EXPECT_FALSE(wire.search(rom));
+}
+
+TEST_F(OneWireTest, WriteSlotsStayWithinResetThreshold) {
+  uint8_t rom[8];
+  DS18B20Bus::makeRom(1, rom);
+  bus.addDevice(rom);
+
+  OneWire wire(TEST_PIN, true);
+  wire.begin();
+  wire.write(0x00);
+  wire.write(0xFF);
+  EXPECT_EQ(0u, bus.getResetCount());
+  EXPECT_EQ(16u, bus.getSlotCount());
+  EXPECT_LT(bus.getLongestLowMicros(), 120u);
+}
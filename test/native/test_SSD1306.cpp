@@ -0,0 +1,505 @@
+// test_SSD1306.cpp - SSD1306 framebuffer and flush tests
+
+#include <gtest/gtest.h>
+
+#include "SSD1306.h"
+#include "SSD1306Controller.h"
+
+#define TEST_WIDTH 128
+#define TEST_HEIGHT 32
+#define TEST_BUFFER_SIZE (TEST_WIDTH * TEST_HEIGHT / 8)
+
+// With SSD1306_WIDTH/SSD1306_HEIGHT fixed at build time, begin() rejects any other geometry.
+static bool isGeometrySupported(int16_t width, int16_t height) {
+#ifdef SSD1306_FIXED_GEOMETRY
+  return width == SSD1306_WIDTH && height == SSD1306_HEIGHT;
+#else
+  (void)width;
+  (void)height;
+  return true;
+#endif
+}
+
+static bool getPixel(const uint8_t* buffer, int16_t x, int16_t y) {
+  return buffer[(y / 8) * TEST_WIDTH + x] & (1 << (y & 7));
+}
+
+// Per-pixel Bresenham as drawLine() did it before its fast paths, clipping each pixel.
+static void referenceLine(uint8_t* buffer, int16_t width, int16_t height, int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t color) {
+  int16_t dx = abs(x1 - x0);
+  int16_t dy = abs(y1 - y0);
+  int8_t sx = x0 < x1 ? 1 : -1;
+  int8_t sy = y0 < y1 ? 1 : -1;
+  int16_t err = dx - dy;
+  while (true) {
+    if (x0 >= 0 && x0 < width && y0 >= 0 && y0 < height) {
+      uint8_t bit = 1 << (y0 & 7);
+      uint8_t& byte = buffer[x0 + (y0 / 8) * width];
+      byte = (color == SSD1306_WHITE) ? (byte | bit) : (byte & ~bit);
+    }
+    if (x0 == x1 && y0 == y1) {
+      break;
+    }
+    int16_t e2 = err * 2;
+    if (e2 > -dy) {
+      err -= dy;
+      x0 += sx;
+    }
+    if (e2 < dx) {
+      err += dx;
+      y0 += sy;
+    }
+  }
+}
+
+// Per-bit drawChar() as it was before the scaled-column lookup tables: every target bit works out
+// its font row with fontY / size.
+static void referenceChar(uint8_t* buffer, int16_t width, int16_t height, int16_t x, int16_t y, char c, uint8_t size, uint8_t color, uint8_t bg) {
+  int8_t idx = Font5x7_GetIndex(c);
+  if (idx < 0) {
+    idx = 0;
+  }
+  if (x < 0 || x + FONT5X7_WIDTH * size > width) return;
+  if (y < 0 || y >= height) return;
+
+  uint16_t totalHeight = FONT5X7_HEIGHT * size;
+  uint8_t startPage = y / 8;
+  uint8_t endPage = (y + totalHeight - 1) / 8;
+  if (endPage >= height / 8) {
+    endPage = height / 8 - 1;
+  }
+
+  for (uint8_t i = 0; i < FONT5X7_WIDTH; i++) {
+    uint8_t line = Font5x7[idx * FONT5X7_WIDTH + i];
+    for (uint8_t page = startPage; page <= endPage; page++) {
+      uint8_t pageBits = 0;
+      uint8_t bgBits = 0;
+      for (uint8_t b = 0; b < 8; b++) {
+        int16_t fontY = page * 8 + b - y;
+        if (fontY < 0 || fontY >= (int16_t)totalHeight) {
+          continue;
+        }
+        if (line & (1 << (fontY / size))) {
+          pageBits |= (1 << b);
+        } else {
+          bgBits |= (1 << b);
+        }
+      }
+      for (uint8_t col = 0; col < size; col++) {
+        uint8_t& byte = buffer[page * width + x + i * size + col];
+        if (bg != color) {
+          byte = (color == SSD1306_WHITE) ? pageBits : bgBits;
+        } else if (color == SSD1306_WHITE) {
+          byte |= pageBits;
+        } else {
+          byte &= ~pageBits;
+        }
+      }
+    }
+  }
+}
+
+class SSD1306Test : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    memset(buffer, 0, sizeof(buffer));
+    memset(shadow, 0, sizeof(shadow));
+    Wire.resetCounters();
+  }
+
+  uint8_t buffer[TEST_BUFFER_SIZE];
+  uint8_t shadow[TEST_BUFFER_SIZE];
+};
+
+TEST_F(SSD1306Test, BeginSendsInitInOneTransaction) {
+  SSD1306 display(TEST_WIDTH, TEST_HEIGHT, buffer);
+  EXPECT_TRUE(display.begin());
+  EXPECT_EQ(1u, Wire.getTransactions());
+  EXPECT_EQ(0u, Wire.getOverflows());
+  EXPECT_EQ(TEST_WIDTH, display.getWidth());
+  EXPECT_EQ(TEST_HEIGHT, display.getHeight());
+}
+
+TEST_F(SSD1306Test, BeginRejectsUnsupportedGeometry) {
+  uint8_t small[64 * 16 / 8];
+  SSD1306 display(64, 16, small);
+  EXPECT_EQ(isGeometrySupported(64, 16), display.begin());
+  if (!isGeometrySupported(64, 16)) {
+    EXPECT_EQ(0u, Wire.getTransactions());
+  }
+}
+
+TEST_F(SSD1306Test, DrawPixelSetsAndClearsBits) {
+  SSD1306 display(TEST_WIDTH, TEST_HEIGHT, buffer);
+  display.begin();
+
+  display.drawPixel(5, 10, SSD1306_WHITE);
+  EXPECT_TRUE(getPixel(buffer, 5, 10));
+  EXPECT_EQ(1 << 2, buffer[TEST_WIDTH + 5]);
+
+  display.drawPixel(5, 10, SSD1306_BLACK);
+  EXPECT_FALSE(getPixel(buffer, 5, 10));
+
+  // Off-screen pixels are clipped.
+  display.drawPixel(-1, 0, SSD1306_WHITE);
+  display.drawPixel(TEST_WIDTH, 0, SSD1306_WHITE);
+  display.drawPixel(0, TEST_HEIGHT, SSD1306_WHITE);
+  for (size_t i = 0; i < sizeof(buffer); i++) {
+    EXPECT_EQ(0, buffer[i]);
+  }
+}
+
+TEST_F(SSD1306Test, FillRectMatchesPixels) {
+  SSD1306 display(TEST_WIDTH, TEST_HEIGHT, buffer);
+  display.begin();
+
+  srand(3);
+  for (int i = 0; i < 500; i++) {
+    int16_t x = rand() % 160 - 16;
+    int16_t y = rand() % 48 - 8;
+    int16_t w = rand() % 64;
+    int16_t h = rand() % 40;
+    uint8_t color = rand() & 1;
+
+    uint8_t expected[TEST_BUFFER_SIZE];
+    memcpy(expected, buffer, sizeof(buffer));
+    for (int16_t py = y; py < y + h; py++) {
+      for (int16_t px = x; px < x + w; px++) {
+        if (px < 0 || px >= TEST_WIDTH || py < 0 || py >= TEST_HEIGHT) continue;
+        uint8_t mask = 1 << (py & 7);
+        uint8_t& byte = expected[(py / 8) * TEST_WIDTH + px];
+        byte = color ? (byte | mask) : (byte & ~mask);
+      }
+    }
+
+    display.fillRect(x, y, w, h, color);
+    ASSERT_EQ(0, memcmp(expected, buffer, sizeof(buffer))) << "rect " << x << "," << y << " " << w << "x" << h;
+  }
+}
+
+TEST_F(SSD1306Test, DisplaySendsWholeFrameAfterBegin) {
+  SSD1306 display(TEST_WIDTH, TEST_HEIGHT, buffer);
+  display.begin();
+  Wire.resetCounters();
+
+  display.display();
+  EXPECT_FALSE(display.isBusy());
+  EXPECT_GE(Wire.getBytesWritten(), (unsigned long)TEST_BUFFER_SIZE);
+  EXPECT_EQ(0u, Wire.getOverflows());
+
+  // Nothing drawn since: the next flush sends nothing.
+  Wire.resetCounters();
+  display.display();
+  EXPECT_EQ(0u, Wire.getTransactions());
+}
+
+TEST_F(SSD1306Test, ShadowBufferSkipsUnchangedBytes) {
+  SSD1306 display(TEST_WIDTH, TEST_HEIGHT, buffer, &Wire, shadow);
+  display.begin();
+  display.display();
+
+  // Redrawing the same pixel dirties its column but changes no byte.
+  display.drawPixel(40, 3, SSD1306_WHITE);
+  display.display();
+  Wire.resetCounters();
+  display.drawPixel(40, 3, SSD1306_WHITE);
+  display.display();
+  EXPECT_EQ(0u, Wire.getTransactions());
+  EXPECT_EQ(0, memcmp(buffer, shadow, sizeof(buffer)));
+}
+
+TEST_F(SSD1306Test, AsyncFlushSendsOneTransactionPerUpdate) {
+  SSD1306 display(TEST_WIDTH, TEST_HEIGHT, buffer);
+  display.begin();
+  Wire.resetCounters();
+
+  display.displayAsync();
+  EXPECT_TRUE(display.isBusy());
+  unsigned long updates = 0;
+  while (display.update()) {
+    updates++;
+    EXPECT_EQ(updates, Wire.getTransactions());
+  }
+  EXPECT_FALSE(display.isBusy());
+  EXPECT_GT(updates, 0u);
+}
+
+TEST_F(SSD1306Test, TextBoundsScaleWithSize) {
+  SSD1306 display(TEST_WIDTH, TEST_HEIGHT, buffer);
+  display.begin();
+
+  int16_t x1, y1;
+  uint16_t w, h;
+  display.setTextSize(2);
+  display.getTextBounds("12.3", 0, 0, &x1, &y1, &w, &h);
+  EXPECT_EQ(4 * (FONT5X7_WIDTH + 1) * 2, w);
+  EXPECT_EQ(FONT5X7_HEIGHT * 2, h);
+}
+
+// Random lines, on screen or with ends up to margin pixels off it, against the reference.
+static void expectLinesMatchReference(int16_t width, int16_t height, int16_t margin, unsigned seed) {
+  const size_t size = width * height / 8;
+  uint8_t buffer[128 * 64 / 8];
+  uint8_t expected[128 * 64 / 8];
+  SSD1306 display(width, height, buffer);
+  ASSERT_EQ(isGeometrySupported(width, height), display.begin());
+  if (!isGeometrySupported(width, height)) return;
+
+  srand(seed);
+  for (size_t i = 0; i < size; i++) {
+    buffer[i] = (uint8_t)rand();
+  }
+  memcpy(expected, buffer, size);
+
+  for (int i = 0; i < 20000; i++) {
+    int16_t x0 = rand() % (width + 2 * margin) - margin;
+    int16_t y0 = rand() % (height + 2 * margin) - margin;
+    int16_t x1 = rand() % (width + 2 * margin) - margin;
+    int16_t y1 = rand() % (height + 2 * margin) - margin;
+    if (rand() % 4 == 0) {
+      // Short segments, as in the charts.
+      x1 = x0 + rand() % 7 - 3;
+      y1 = y0 + rand() % 33 - 16;
+    }
+    uint8_t color = (rand() % 3 == 0) ? SSD1306_BLACK : SSD1306_WHITE;
+
+    referenceLine(expected, width, height, x0, y0, x1, y1, color);
+    display.drawLine(x0, y0, x1, y1, color);
+    ASSERT_EQ(0, memcmp(expected, buffer, size)) << width << "x" << height << " line " << x0 << "," << y0 << " to " << x1 << "," << y1 << " color " << (int)color;
+  }
+}
+
+TEST_F(SSD1306Test, DrawLineOnScreenMatchesBresenham) {
+  expectLinesMatchReference(128, 32, 0, 18);
+  expectLinesMatchReference(128, 64, 0, 19);
+}
+
+TEST_F(SSD1306Test, DrawLineClippedMatchesBresenham) {
+  expectLinesMatchReference(128, 32, 100, 20);
+  expectLinesMatchReference(128, 64, 40, 21);
+}
+
+// Random characters, positions, colours and sizes 1-5 against the per-bit reference; sizes 2 and
+// 3 take the lookup-table path.
+static void expectCharsMatchReference(int16_t width, int16_t height, unsigned seed) {
+  const size_t size = width * height / 8;
+  uint8_t buffer[128 * 64 / 8];
+  uint8_t expected[128 * 64 / 8];
+  SSD1306 display(width, height, buffer);
+  ASSERT_EQ(isGeometrySupported(width, height), display.begin());
+  if (!isGeometrySupported(width, height)) return;
+
+  srand(seed);
+  for (size_t i = 0; i < size; i++) {
+    buffer[i] = (uint8_t)rand();
+  }
+  memcpy(expected, buffer, size);
+
+  for (int i = 0; i < 20000; i++) {
+    char c = (char)(rand() % 0x80);
+    int16_t x = rand() % (width + 4) - 4;
+    int16_t y = rand() % (height + 4) - 4;
+    uint8_t textSize = (i % 4 == 0) ? 1 + rand() % 5 : 2 + (i & 1);
+    uint8_t color = rand() & 1;
+    uint8_t bg = rand() & 1;
+
+    referenceChar(expected, width, height, x, y, c, textSize, color, bg);
+    display.setTextSize(textSize);
+    display.setTextColor(color, bg);
+    display.drawChar(x, y, c, color);
+    ASSERT_EQ(0, memcmp(expected, buffer, size)) << width << "x" << height << " char " << (int)c << " at " << x << "," << y << " size " << (int)textSize << " color " << (int)color << " bg " << (int)bg;
+  }
+}
+
+TEST_F(SSD1306Test, DrawCharMatchesPerBitReference) {
+  expectCharsMatchReference(128, 32, 22);
+  expectCharsMatchReference(128, 64, 23);
+}
+
+// Controller RAM against the framebuffer: random frames are drawn and flushed the way loop()
+// does it, and after every flush the RAM must hold exactly what the buffer holds.
+class SSD1306ControllerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    setMicros(0);
+    controller.reset();
+    Wire.resetCounters();
+    Wire.setListener(&controller);
+  }
+
+  void TearDown() override {
+    Wire.setListener(nullptr);
+  }
+
+  // A few drawing operations, biased towards what the views do: digits, chart segments, and
+  // scrolling the chart area.
+  static void drawRandomFrame(SSD1306& display, bool allowRotation) {
+    int16_t width = display.getWidth();
+    int16_t height = display.getHeight();
+    int ops = 1 + rand() % 4;
+    for (int i = 0; i < ops; i++) {
+      int r = rand() % 100;
+      if (r < 20) {
+        display.drawPixel(rand() % (width + 4) - 2, rand() % (height + 4) - 2, rand() & 1);
+      } else if (r < 40) {
+        display.drawLine(rand() % width, rand() % height, rand() % width, rand() % height, (rand() % 4) ? SSD1306_WHITE : SSD1306_BLACK);
+      } else if (r < 50) {
+        display.fillRect(rand() % width - 8, rand() % height - 4, rand() % 40, rand() % 20, rand() & 1);
+      } else if (r < 65) {
+        display.setTextSize(1 + rand() % 3);
+        display.setTextColor(SSD1306_WHITE, SSD1306_BLACK);
+        display.drawChar(rand() % width - 4, rand() % height - 4, '0' + rand() % 10, SSD1306_WHITE);
+      } else if (r < 90) {
+        // Chart area below the digits, page aligned.
+        display.scrollRegionLeft(0, 16, width, height - 16, 1 + rand() % 4);
+      } else if (r < 93) {
+        display.clearDisplay();
+      } else if (r < 95 && allowRotation) {
+        display.setRotation((rand() & 1) ? 2 : 0);
+      }
+    }
+  }
+
+  // Flushes as loop() does, with time passing between update() calls for the scroll pacing.
+  static void flush(SSD1306& display) {
+    display.displayAsync();
+    while (display.update()) {
+      advanceMicros(1000);
+    }
+  }
+
+  void expectRamFollowsBuffer(int16_t width, int16_t height, uint8_t colOffset, bool useShadow, bool hardwareScroll, int frames, unsigned seed) {
+    uint8_t buffer[128 * 32 / 8];
+    uint8_t shadow[128 * 32 / 8];
+    SSD1306 display(width, height, buffer, &Wire, useShadow ? shadow : nullptr);
+    ASSERT_EQ(isGeometrySupported(width, height), display.begin());
+    if (!isGeometrySupported(width, height)) return;
+    display.setHardwareScroll(hardwareScroll);
+    flush(display);
+    ASSERT_TRUE(controller.matches(buffer, width, height, colOffset));
+
+    srand(seed);
+    for (int frame = 0; frame < frames; frame++) {
+      drawRandomFrame(display, true);
+      flush(display);
+      ASSERT_TRUE(controller.matches(buffer, width, height, colOffset)) << "frame " << frame;
+      if (useShadow) {
+        ASSERT_EQ(0, memcmp(buffer, shadow, width * height / 8)) << "frame " << frame;
+      }
+    }
+    EXPECT_EQ(0u, controller.getProtocolErrors());
+    EXPECT_EQ(0u, controller.getScrollTimingErrors());
+    EXPECT_EQ(0u, Wire.getOverflows());
+    if (hardwareScroll) {
+      EXPECT_GT(controller.getScrollCommands(), 0u);
+    } else {
+      EXPECT_EQ(0u, controller.getScrollCommands());
+    }
+  }
+
+  SSD1306Controller controller;
+};
+
+TEST_F(SSD1306ControllerTest, BeginInitializesPanel) {
+  uint8_t buffer[TEST_BUFFER_SIZE];
+  SSD1306 display(TEST_WIDTH, TEST_HEIGHT, buffer);
+  display.begin();
+  display.display();
+  EXPECT_TRUE(controller.isDisplayOn());
+  EXPECT_TRUE(controller.isSegmentRemapped());
+  EXPECT_TRUE(controller.isComScanReversed());
+  EXPECT_TRUE(controller.matches(buffer, TEST_WIDTH, TEST_HEIGHT));
+
+  display.setRotation(2);
+  EXPECT_FALSE(controller.isSegmentRemapped());
+  EXPECT_FALSE(controller.isComScanReversed());
+}
+
+TEST_F(SSD1306ControllerTest, RamMatchesBufferWithoutShadow) {
+  expectRamFollowsBuffer(128, 32, 0, false, false, 20000, 41);
+}
+
+TEST_F(SSD1306ControllerTest, RamMatchesBufferWithShadow) {
+  expectRamFollowsBuffer(128, 32, 0, true, false, 20000, 42);
+}
+
+TEST_F(SSD1306ControllerTest, RamMatchesBufferWithHardwareScroll) {
+  expectRamFollowsBuffer(128, 32, 0, true, true, 20000, 43);
+}
+
+TEST_F(SSD1306ControllerTest, RamMatchesBufferWithHardwareScrollWithoutShadow) {
+  expectRamFollowsBuffer(128, 32, 0, false, true, 20000, 44);
+}
+
+TEST_F(SSD1306ControllerTest, RamMatchesBufferWithColumnOffset) {
+  expectRamFollowsBuffer(96, 32, 16, true, true, 5000, 45);
+}
+
+TEST_F(SSD1306ControllerTest, RamMatchesBufferOn16RowPanel) {
+  expectRamFollowsBuffer(128, 16, 0, true, false, 5000, 46);
+}
+
+#ifdef SSD1306_QUARTER_ROTATION
+// In a quarter turn the drawing area is the panel transposed: RAM page p, column c holds drawing
+// pixels x = 8p..8p+7 of row y = c. Remap and scan direction only change how the panel shows RAM.
+static bool ramMatchesTransposed(const SSD1306Controller& controller, const uint8_t* buffer, int16_t width, int16_t height) {
+  for (int16_t page = 0; page < width / 8; page++) {
+    for (int16_t column = 0; column < height; column++) {
+      uint8_t expected = 0;
+      for (uint8_t b = 0; b < 8; b++) {
+        int16_t x = page * 8 + b;
+        if (buffer[(column / 8) * width + x] & (1 << (column & 7))) {
+          expected |= 1 << b;
+        }
+      }
+      if (controller.getRam(page, column) != expected) return false;
+    }
+  }
+  return true;
+}
+
+class SSD1306RotationTest : public SSD1306ControllerTest {
+ protected:
+  // Random frames in rotation 1 or 3, with a change of rotation now and then; after every flush
+  // RAM must hold the buffer, transposed while the drawing area is portrait.
+  void expectRotatedRamFollowsBuffer(bool useShadow, unsigned seed) {
+    uint8_t buffer[TEST_BUFFER_SIZE];
+    uint8_t shadow[TEST_BUFFER_SIZE];
+    SSD1306 display(TEST_WIDTH, TEST_HEIGHT, buffer, &Wire, useShadow ? shadow : nullptr);
+    ASSERT_TRUE(display.begin());
+    display.setHardwareScroll(true);
+
+    srand(seed);
+    uint8_t rotation = 1;
+    for (int frame = 0; frame < 5000; frame++) {
+      if (frame % 200 == 0) {
+        rotation = (frame % 400 == 0) ? 1 + 2 * (rand() & 1) : rand() % 4;
+        display.setRotation(rotation);
+        ASSERT_EQ(rotation, display.getRotation());
+        ASSERT_EQ((rotation & 1) ? TEST_HEIGHT : TEST_WIDTH, display.getWidth());
+        ASSERT_EQ((rotation & 1) ? TEST_WIDTH : TEST_HEIGHT, display.getHeight());
+        ASSERT_EQ(rotation == 0 || rotation == 3, controller.isSegmentRemapped()) << "rotation " << (int)rotation;
+        ASSERT_EQ(rotation < 2, controller.isComScanReversed()) << "rotation " << (int)rotation;
+      }
+      drawRandomFrame(display, false);
+      flush(display);
+      if (rotation & 1) {
+        ASSERT_TRUE(ramMatchesTransposed(controller, buffer, display.getWidth(), display.getHeight())) << "frame " << frame << " rotation " << (int)rotation;
+      } else {
+        ASSERT_TRUE(controller.matches(buffer, TEST_WIDTH, TEST_HEIGHT)) << "frame " << frame << " rotation " << (int)rotation;
+      }
+    }
+    EXPECT_EQ(0u, controller.getProtocolErrors());
+    EXPECT_EQ(0u, controller.getScrollTimingErrors());
+    EXPECT_EQ(0u, Wire.getOverflows());
+  }
+};
+
+TEST_F(SSD1306RotationTest, RamMatchesRotatedBufferWithoutShadow) {
+  expectRotatedRamFollowsBuffer(false, 47);
+}
+
+TEST_F(SSD1306RotationTest, RamMatchesRotatedBufferWithShadow) {
+  expectRotatedRamFollowsBuffer(true, 48);
+}
+#endif
@@ -0,0 +1,183 @@
+// test_SensorDataHistory.cpp - Sensor data history tests against a brute-force scan
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "SensorDataHistory.h"
+
+static const size_t testSizes[] = {1, 2, 5, 44, 300};
+
+// Min/max over the newest `count` of the values a history of `size` entries still holds,
+// skipping invalid ones.
+static void referenceMinMax(const std::vector<int16_t>& values, size_t size, size_t count, int16_t& minValue, int16_t& maxValue) {
+  minValue = INVALID_SENSOR_VALUE;
+  maxValue = INVALID_SENSOR_VALUE;
+  for (size_t i = 0; i < count && i < size && i < values.size(); i++) {
+    int16_t value = values[values.size() - 1 - i];
+    if (!IS_VALID_SENSOR_VALUE(value)) continue;
+    if (!IS_VALID_SENSOR_VALUE(minValue) || value < minValue) minValue = value;
+    if (!IS_VALID_SENSOR_VALUE(maxValue) || value > maxValue) maxValue = value;
+  }
+}
+
+// Mostly a random walk, with single invalid samples and longer sensor dropouts.
+static int16_t nextValue(int16_t& walk, int& dropout) {
+  if (dropout > 0) {
+    dropout--;
+    return INVALID_SENSOR_VALUE;
+  }
+  int r = rand() % 100;
+  if (r < 5) {
+    return INVALID_SENSOR_VALUE;
+  }
+  if (r < 7) {
+    dropout = rand() % 400;
+    return INVALID_SENSOR_VALUE;
+  }
+  if (r < 9) {
+    // Repeated extremes exercise ties in the deques.
+    return (rand() & 1) ? INT16_MAX : INT16_MIN + 1;
+  }
+  walk += rand() % 61 - 30;
+  return walk;
+}
+
+class SensorDataHistoryTest : public ::testing::TestWithParam<size_t> {
+ protected:
+  void SetUp() override {
+    size = GetParam();
+    buffer.assign(size, 0);
+    untrackedBuffer.assign(size, 0);
+    minIndexBuffer.assign(size, 0);
+    maxIndexBuffer.assign(size, 0);
+  }
+
+  void expectWindows(const SensorDataHistory& history, const std::vector<int16_t>& values, size_t step) {
+    size_t windows[] = {history.getCount(), size, size + 1, 1, history.getCount() / 2, history.getCount() > 0 ? history.getCount() - 1 : 0};
+    for (size_t count : windows) {
+      int16_t expectedMin, expectedMax, minValue, maxValue;
+      referenceMinMax(values, size, count, expectedMin, expectedMax);
+      history.getMinMaxValue(count, minValue, maxValue);
+      ASSERT_EQ(expectedMin, minValue) << "size " << size << " step " << step << " count " << count;
+      ASSERT_EQ(expectedMax, maxValue) << "size " << size << " step " << step << " count " << count;
+    }
+  }
+
+  size_t size;
+  std::vector<int16_t> buffer;
+  std::vector<int16_t> untrackedBuffer;
+  std::vector<uint16_t> minIndexBuffer;
+  std::vector<uint16_t> maxIndexBuffer;
+};
+
+TEST_P(SensorDataHistoryTest, MinMaxMatchesScanWithIndexBuffers) {
+  SensorDataHistory history(buffer.data(), size, minIndexBuffer.data(), maxIndexBuffer.data());
+  history.begin();
+
+  srand(size);
+  std::vector<int16_t> values;
+  int16_t walk = 2000;
+  int dropout = 0;
+  for (size_t step = 0; step < 20000; step++) {
+    int16_t value = nextValue(walk, dropout);
+    history.prepend(value);
+    values.push_back(value);
+    ASSERT_EQ(std::min(values.size(), size), history.getCount());
+    ASSERT_EQ(value, history.getValue(0));
+    expectWindows(history, values, step);
+  }
+}
+
+TEST_P(SensorDataHistoryTest, MinMaxMatchesScanWithoutIndexBuffers) {
+  SensorDataHistory history(untrackedBuffer.data(), size);
+  history.begin();
+
+  srand(size + 1);
+  std::vector<int16_t> values;
+  int16_t walk = -500;
+  int dropout = 0;
+  for (size_t step = 0; step < 5000; step++) {
+    int16_t value = nextValue(walk, dropout);
+    history.prepend(value);
+    values.push_back(value);
+    expectWindows(history, values, step);
+  }
+}
+
+TEST_P(SensorDataHistoryTest, TrackedAndScannedAgreeAcrossSequenceWrap) {
+  SensorDataHistory tracked(buffer.data(), size, minIndexBuffer.data(), maxIndexBuffer.data());
+  SensorDataHistory scanned(untrackedBuffer.data(), size);
+  tracked.begin();
+  scanned.begin();
+
+  srand(size + 2);
+  int16_t walk = 0;
+  int dropout = 0;
+  // Run past the 16-bit sequence wrap.
+  for (unsigned long step = 0; step < 70000; step++) {
+    int16_t value = nextValue(walk, dropout);
+    tracked.prepend(value);
+    scanned.prepend(value);
+    if (step % 7 != 0 && step < 65000) continue;
+
+    int16_t trackedMin, trackedMax, scannedMin, scannedMax;
+    tracked.getMinMaxValue(size, trackedMin, trackedMax);
+    scanned.getMinMaxValue(size, scannedMin, scannedMax);
+    ASSERT_EQ(scannedMin, trackedMin) << "step " << step;
+    ASSERT_EQ(scannedMax, trackedMax) << "step " << step;
+  }
+  EXPECT_EQ((uint16_t)70000, tracked.getSequence());
+}
+
+TEST_P(SensorDataHistoryTest, BeginClearsHistory) {
+  SensorDataHistory history(buffer.data(), size, minIndexBuffer.data(), maxIndexBuffer.data());
+  history.begin();
+  for (int i = 0; i < 10; i++) {
+    history.prepend(100 + i);
+  }
+  history.begin();
+
+  int16_t minValue, maxValue;
+  history.getMinMaxValue(size, minValue, maxValue);
+  EXPECT_EQ(0u, history.getCount());
+  EXPECT_FALSE(IS_VALID_SENSOR_VALUE(minValue));
+  EXPECT_FALSE(IS_VALID_SENSOR_VALUE(maxValue));
+  EXPECT_FALSE(IS_VALID_SENSOR_VALUE(history.getValue(0)));
+
+  history.prepend(-40);
+  history.getMinMaxValue(size, minValue, maxValue);
+  EXPECT_EQ(-40, minValue);
+  EXPECT_EQ(-40, maxValue);
+}
+
+// Sequence distances are 16 bits, so a history above 65535 entries ignores its index buffers.
+TEST(SensorDataHistoryLimitTest, OversizedHistoryScans) {
+  const size_t size = 65536 + 100;
+  std::vector<int16_t> buffer(size);
+  std::vector<uint16_t> minIndices(size);
+  std::vector<uint16_t> maxIndices(size);
+  SensorDataHistory history(buffer.data(), size, minIndices.data(), maxIndices.data());
+  history.begin();
+
+  srand(3);
+  std::vector<int16_t> values;
+  for (size_t step = 0; step < size + 200; step++) {
+    int16_t value = (rand() % 20 == 0) ? INVALID_SENSOR_VALUE : rand() % 2001 - 1000;
+    // Extremes that leave the window after the sequence numbers have wrapped.
+    if (step == 100) value = -30000;
+    if (step == 101) value = 30000;
+    history.prepend(value);
+    values.push_back(value);
+    if (step % 8192 != 0 && (step < size + 95 || step > size + 105)) continue;
+
+    int16_t expectedMin, expectedMax, minValue, maxValue;
+    referenceMinMax(values, size, size, expectedMin, expectedMax);
+    history.getMinMaxValue(size, minValue, maxValue);
+    ASSERT_EQ(expectedMin, minValue) << "step " << step;
+    ASSERT_EQ(expectedMax, maxValue) << "step " << step;
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Sizes, SensorDataHistoryTest, ::testing::ValuesIn(testSizes));
@@ -0,0 +1,166 @@
+// test_SensorDataTrend.cpp - Minute / hour / day trend tests
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "SensorDataTrend.h"
+
+#define MINUTE_MS 60000UL
+
+class SensorDataTrendTest : public ::testing::Test {
+ protected:
+  void init(size_t size) {
+    buffer.assign(SensorDataTrend::TIER_COUNT * size, SensorDataTrend::Bucket());
+    trend = new SensorDataTrend(buffer.data(), size);
+  }
+
+  void TearDown() override {
+    delete trend;
+  }
+
+  void expectBucket(SensorDataTrend::Tier tier, size_t index, int16_t minValue, int16_t maxValue, int16_t meanValue) {
+    SensorDataTrend::Bucket bucket = trend->getBucket(tier, index);
+    EXPECT_EQ(minValue, bucket.minValue) << "tier " << tier << " index " << index;
+    EXPECT_EQ(maxValue, bucket.maxValue) << "tier " << tier << " index " << index;
+    EXPECT_EQ(meanValue, bucket.meanValue) << "tier " << tier << " index " << index;
+  }
+
+  void expectInvalid(SensorDataTrend::Tier tier, size_t index) {
+    expectBucket(tier, index, INVALID_SENSOR_VALUE, INVALID_SENSOR_VALUE, INVALID_SENSOR_VALUE);
+  }
+
+  std::vector<SensorDataTrend::Bucket> buffer;
+  SensorDataTrend* trend = nullptr;
+};
+
+TEST_F(SensorDataTrendTest, ClosesMinuteBucketWithMinMaxMean) {
+  init(4);
+  trend->add(10, 0);
+  trend->add(30, 10000);
+  trend->add(20, 59999);
+  EXPECT_EQ(0u, trend->getCount(SensorDataTrend::TIER_MINUTE));
+
+  trend->add(5, MINUTE_MS);
+  ASSERT_EQ(1u, trend->getCount(SensorDataTrend::TIER_MINUTE));
+  expectBucket(SensorDataTrend::TIER_MINUTE, 0, 10, 30, 20);
+  EXPECT_EQ(1, trend->getSequence());
+
+  // Boundaries stay on the minute grid of the first sample.
+  trend->add(7, 2 * MINUTE_MS + 500);
+  ASSERT_EQ(2u, trend->getCount(SensorDataTrend::TIER_MINUTE));
+  expectBucket(SensorDataTrend::TIER_MINUTE, 0, 5, 5, 5);
+  expectBucket(SensorDataTrend::TIER_MINUTE, 1, 10, 30, 20);
+}
+
+TEST_F(SensorDataTrendTest, SkipsInvalidSamples) {
+  init(4);
+  trend->add(INVALID_SENSOR_VALUE, 0);
+  trend->add(100, 1000);
+  trend->add(INVALID_SENSOR_VALUE, 2000);
+  trend->add(201, 3000);
+  trend->add(INVALID_SENSOR_VALUE, MINUTE_MS);
+  trend->add(INVALID_SENSOR_VALUE, 2 * MINUTE_MS);
+
+  ASSERT_EQ(2u, trend->getCount(SensorDataTrend::TIER_MINUTE));
+  expectInvalid(SensorDataTrend::TIER_MINUTE, 0);
+  expectBucket(SensorDataTrend::TIER_MINUTE, 1, 100, 201, 150);
+
+  int16_t minValue, maxValue;
+  trend->getMinMaxValue(SensorDataTrend::TIER_MINUTE, 4, minValue, maxValue);
+  EXPECT_EQ(100, minValue);
+  EXPECT_EQ(201, maxValue);
+  trend->getMinMaxValue(SensorDataTrend::TIER_MINUTE, 1, minValue, maxValue);
+  EXPECT_FALSE(IS_VALID_SENSOR_VALUE(minValue));
+  EXPECT_FALSE(IS_VALID_SENSOR_VALUE(maxValue));
+}
+
+TEST_F(SensorDataTrendTest, RollsMinutesIntoHours) {
+  init(4);
+  // One sample per minute, valued by its minute.
+  for (int16_t minute = 0; minute <= 60; minute++) {
+    trend->add(minute, minute * MINUTE_MS);
+  }
+
+  EXPECT_EQ(4u, trend->getCount(SensorDataTrend::TIER_MINUTE));
+  expectBucket(SensorDataTrend::TIER_MINUTE, 0, 59, 59, 59);
+  expectBucket(SensorDataTrend::TIER_MINUTE, 3, 56, 56, 56);
+  ASSERT_EQ(1u, trend->getCount(SensorDataTrend::TIER_HOUR));
+  expectBucket(SensorDataTrend::TIER_HOUR, 0, 0, 59, 29);
+  EXPECT_EQ(0u, trend->getCount(SensorDataTrend::TIER_DAY));
+  EXPECT_EQ(61, trend->getSequence());
+}
+
+TEST_F(SensorDataTrendTest, RollsHoursIntoDays) {
+  init(4);
+  // One sample per minute, valued by ten times its hour.
+  for (unsigned long minute = 0; minute <= 24 * 60; minute++) {
+    trend->add(static_cast<int16_t>(minute / 60 * 10), minute * MINUTE_MS);
+  }
+
+  EXPECT_EQ(4u, trend->getCount(SensorDataTrend::TIER_HOUR));
+  expectBucket(SensorDataTrend::TIER_HOUR, 0, 230, 230, 230);
+  ASSERT_EQ(1u, trend->getCount(SensorDataTrend::TIER_DAY));
+  expectBucket(SensorDataTrend::TIER_DAY, 0, 0, 230, 115);
+}
+
+TEST_F(SensorDataTrendTest, GapClosesOneInvalidBucketPerMinute) {
+  init(8);
+  trend->add(100, 0);
+  trend->add(200, 30000);
+  // No samples for the minutes starting at 1:00 and 2:00.
+  trend->add(300, 3 * MINUTE_MS + 30000);
+
+  ASSERT_EQ(3u, trend->getCount(SensorDataTrend::TIER_MINUTE));
+  expectInvalid(SensorDataTrend::TIER_MINUTE, 0);
+  expectInvalid(SensorDataTrend::TIER_MINUTE, 1);
+  expectBucket(SensorDataTrend::TIER_MINUTE, 2, 100, 200, 150);
+
+  trend->add(400, 4 * MINUTE_MS);
+  ASSERT_EQ(4u, trend->getCount(SensorDataTrend::TIER_MINUTE));
+  expectBucket(SensorDataTrend::TIER_MINUTE, 0, 300, 300, 300);
+  expectBucket(SensorDataTrend::TIER_MINUTE, 3, 100, 200, 150);
+  EXPECT_EQ(4, trend->getSequence());
+
+  int16_t minValue, maxValue;
+  trend->getMinMaxValue(SensorDataTrend::TIER_MINUTE, 4, minValue, maxValue);
+  EXPECT_EQ(100, minValue);
+  EXPECT_EQ(300, maxValue);
+}
+
+TEST_F(SensorDataTrendTest, LongGapIsCappedAtTierSize) {
+  init(4);
+  trend->add(100, 0);
+  unsigned long resume = 10 * MINUTE_MS + 5000;
+  trend->add(200, resume);
+
+  // The data bucket plus one invalid bucket per slot; the older minutes are not replayed.
+  ASSERT_EQ(4u, trend->getCount(SensorDataTrend::TIER_MINUTE));
+  for (size_t i = 0; i < 4; i++) {
+    expectInvalid(SensorDataTrend::TIER_MINUTE, i);
+  }
+  EXPECT_EQ(5, trend->getSequence());
+
+  // The minute grid restarts at the first sample after the gap.
+  trend->add(300, resume + MINUTE_MS - 1);
+  EXPECT_EQ(5, trend->getSequence());
+  trend->add(400, resume + MINUTE_MS);
+  expectBucket(SensorDataTrend::TIER_MINUTE, 0, 200, 300, 250);
+}
+
+TEST_F(SensorDataTrendTest, BeginClearsTiers) {
+  init(4);
+  for (int16_t minute = 0; minute <= 60; minute++) {
+    trend->add(minute, minute * MINUTE_MS);
+  }
+  trend->begin();
+
+  EXPECT_EQ(0u, trend->getCount(SensorDataTrend::TIER_MINUTE));
+  EXPECT_EQ(0u, trend->getCount(SensorDataTrend::TIER_HOUR));
+  EXPECT_EQ(0, trend->getSequence());
+  expectInvalid(SensorDataTrend::TIER_MINUTE, 0);
+
+  trend->add(-40, 1000000);
+  trend->add(-20, 1000000 + MINUTE_MS);
+  expectBucket(SensorDataTrend::TIER_MINUTE, 0, -40, -40, -40);
+}
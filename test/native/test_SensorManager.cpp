@@ -0,0 +1,136 @@
+// test_SensorManager.cpp - Sensor manager tests against the simulated bus
+
+#include <gtest/gtest.h>
+
+#include "DS18B20.h"
+#include "DS18B20Bus.h"
+#include "OneWire.h"
+#include "SensorManager.h"
+
+#define TEST_PIN PC5
+#define TEST_INTERVAL_MS 1000
+
+class SensorManagerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    resetPins();
+    setMicros(0);
+    attachPinModel(TEST_PIN, &bus);
+  }
+
+  void TearDown() override {
+    attachPinModel(TEST_PIN, nullptr);
+  }
+
+  uint8_t addDevice(uint32_t serial, int16_t raw, bool parasite = false) {
+    uint8_t rom[8];
+    DS18B20Bus::makeRom(serial, rom);
+    uint8_t index = bus.addDevice(rom, parasite);
+    bus.setTemperature(index, raw);
+    return index;
+  }
+
+  // Runs update() the way loop() does, sleeping until the next event, until a result arrives.
+  bool runUntilReady(SensorManager& manager, unsigned long limitMs) {
+    unsigned long start = millis();
+    while (millis() - start < limitMs) {
+      manager.update();
+      if (manager.isReady()) return true;
+      delay(manager.getMillisUntilNextEvent());
+    }
+    return false;
+  }
+
+  DS18B20Bus bus;
+};
+
+TEST_F(SensorManagerTest, DeliversReadingAfterConversion) {
+  addDevice(1, 0x0191);
+  OneWire wire(TEST_PIN, true);
+  DS18B20 sensor(wire);
+  SensorManager manager(sensor, TEST_INTERVAL_MS);
+  manager.begin();
+
+  ASSERT_TRUE(runUntilReady(manager, 2000));
+  SensorManager::SensorData data = manager.getSensorData();
+  EXPECT_EQ(1, data.channelCount);
+  EXPECT_EQ(12, data.resolution);
+  EXPECT_EQ(2506, data.temperature[0]);
+  // External power: the end of the conversion is seen by polling, within one poll interval.
+  EXPECT_GE(data.conversionTimeMs, 750);
+  EXPECT_LE(data.conversionTimeMs, 760);
+}
+
+TEST_F(SensorManagerTest, PollingEndsFastConversionEarly) {
+  bus.setConversionMicros(addDevice(1, 0x0191), 600000UL);
+  OneWire wire(TEST_PIN, true);
+  DS18B20 sensor(wire);
+  SensorManager manager(sensor, TEST_INTERVAL_MS);
+  manager.begin();
+
+  ASSERT_TRUE(runUntilReady(manager, 2000));
+  SensorManager::SensorData data = manager.getSensorData();
+  EXPECT_EQ(2506, data.temperature[0]);
+  // The result is read as soon as the device reports done, not after the worst-case wait.
+  EXPECT_GE(data.conversionTimeMs, 600);
+  EXPECT_LE(data.conversionTimeMs, 610);
+  EXPECT_LE(data.conversionTimeMs + 100, sensor.getConversionTimeMs());
+}
+
+TEST_F(SensorManagerTest, WaitsOutConversionOnParasitePower) {
+  // A parasite-powered device cannot signal completion, so even a fast one is waited out.
+  bus.setConversionMicros(addDevice(1, 0x0100, true), 400000UL);
+  OneWire wire(TEST_PIN, true);
+  DS18B20 sensor(wire, 0, 9);
+  SensorManager manager(sensor, TEST_INTERVAL_MS);
+  manager.begin();
+
+  ASSERT_TRUE(runUntilReady(manager, 2000));
+  SensorManager::SensorData data = manager.getSensorData();
+  EXPECT_EQ(1600, data.temperature[0]);
+  EXPECT_EQ(sensor.getConversionTimeMs(), data.conversionTimeMs);
+}
+
+TEST_F(SensorManagerTest, RepeatsAtInterval) {
+  addDevice(1, 0x0100);
+  OneWire wire(TEST_PIN, true);
+  DS18B20 sensor(wire);
+  SensorManager manager(sensor, TEST_INTERVAL_MS);
+  manager.begin();
+
+  ASSERT_TRUE(runUntilReady(manager, 2000));
+  unsigned long first = millis();
+  bus.setTemperature(0, 0x0200);
+  ASSERT_TRUE(runUntilReady(manager, 2000));
+  EXPECT_GE(millis() - first, (unsigned long)TEST_INTERVAL_MS);
+  EXPECT_EQ(3200, manager.getSensorData().temperature[0]);
+}
+
+TEST_F(SensorManagerTest, ReadsEveryChannel) {
+  addDevice(0x11, 0x0100);
+  addDevice(0x22, 0x0100);
+  addDevice(0x33, 0x0100);
+  OneWire wire(TEST_PIN, true);
+  DS18B20 sensor(wire);
+  SensorManager manager(sensor, TEST_INTERVAL_MS);
+  manager.begin();
+
+  ASSERT_TRUE(runUntilReady(manager, 2000));
+  SensorManager::SensorData data = manager.getSensorData();
+  ASSERT_EQ(3, data.channelCount);
+  for (uint8_t i = 0; i < data.channelCount; i++) {
+    EXPECT_EQ(1600, data.temperature[i]);
+  }
+}
+
+TEST_F(SensorManagerTest, MarksFailedChannelInvalid) {
+  addDevice(1, 0x0100);
+  OneWire wire(TEST_PIN, true);
+  DS18B20 sensor(wire);
+  SensorManager manager(sensor, TEST_INTERVAL_MS);
+  manager.begin();
+
+  bus.setCorruptScratchpad(0, true);
+  ASSERT_TRUE(runUntilReady(manager, 2000));
+  EXPECT_FALSE(IS_VALID_TEMPERATURE(manager.getSensorData().temperature[0]));
+}
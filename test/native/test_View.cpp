@@ -0,0 +1,283 @@
+// test_View.cpp - View rendering tests
+
+#include <gtest/gtest.h>
+
+#include "Model.h"
+#include "SSD1306.h"
+#include "SSD1306Controller.h"
+#include "SensorDataHistory.h"
+#include "SensorDataTrend.h"
+#include "View.h"
+
+#define TEST_WIDTH 128
+#define TEST_HEIGHT 32
+#define TEST_BUFFER_SIZE (TEST_WIDTH * TEST_HEIGHT / 8)
+#define TEST_STEP 3
+#define TEST_HISTORY_SIZE ((TEST_WIDTH + TEST_STEP - 1) / TEST_STEP + 1)
+#define TEST_TREND_SIZE 24
+
+class ViewTest : public ::testing::Test {
+ protected:
+  ViewTest()
+      : display(TEST_WIDTH, TEST_HEIGHT, buffer, &Wire, shadow),
+        history(historyBuffer, TEST_HISTORY_SIZE, minIndexBuffer, maxIndexBuffer),
+        trend(trendBuffer, TEST_TREND_SIZE),
+        model(&history, &trend, 1),
+        view(model, display, TEST_STEP) {
+  }
+
+  void SetUp() override {
+    setMicros(0);
+    history.begin();
+    trend.begin();
+    model.begin();
+    view.begin();
+    Wire.resetCounters();
+  }
+
+  void push(int16_t temperature, uint8_t resolution = 12) {
+    SensorManager::SensorData data;
+    data.temperature[0] = temperature;
+    data.channelCount = 1;
+    data.resolution = resolution;
+    data.conversionTimeMs = 750;
+    model.update(data);
+    delay(3000);
+  }
+
+  void renderAndFlush() {
+    ASSERT_TRUE(view.render());
+    while (display.update()) {
+    }
+  }
+
+  // Flushes as loop() does, with time passing between update() calls for the scroll pacing.
+  static void flush(SSD1306& target) {
+    while (target.update()) {
+      advanceMicros(1000);
+    }
+  }
+
+  // Renders every sample through the scrolling chart and, on a second display, as a full redraw
+  // (setViewMode() drops the chart on screen). Frames and controller RAM must stay identical.
+  void expectScrollMatchesRedraw(bool hardwareScroll, unsigned seed) {
+    uint8_t referenceBuffer[TEST_BUFFER_SIZE];
+    SSD1306 reference(TEST_WIDTH, TEST_HEIGHT, referenceBuffer);
+    View referenceView(model, reference, TEST_STEP);
+    referenceView.begin();
+
+    SSD1306Controller controller;
+    Wire.setListener(&controller);
+    view.begin();
+    display.setHardwareScroll(hardwareScroll);
+
+    srand(seed);
+    int16_t walk = 2000;
+    for (int i = 0; i < 600; i++) {
+      int16_t value;
+      if (i % 40 == 39) {
+        value = INVALID_TEMPERATURE_VALUE;
+      } else if (i < 300) {
+        // Extremes recur within every window, so the range holds and the chart scrolls.
+        value = 2000 + (i * 37 % 11) * 10;
+      } else {
+        walk += rand() % 41 - 20;
+        value = walk;
+      }
+      push(value);
+
+      Wire.setListener(&controller);
+      ASSERT_TRUE(view.render());
+      flush(display);
+      Wire.setListener(nullptr);
+      referenceView.setViewMode(View::VIEW_MODE_CHART);
+      ASSERT_TRUE(referenceView.render());
+      flush(reference);
+
+      ASSERT_EQ(0, memcmp(referenceBuffer, buffer, sizeof(buffer))) << "sample " << i;
+      ASSERT_TRUE(controller.matches(referenceBuffer, TEST_WIDTH, TEST_HEIGHT)) << "sample " << i;
+    }
+    EXPECT_EQ(0u, controller.getProtocolErrors());
+    EXPECT_EQ(0u, controller.getScrollTimingErrors());
+    if (hardwareScroll) {
+      EXPECT_GT(controller.getScrollCommands(), 0u);
+    }
+  }
+
+  bool isBlank() const {
+    for (size_t i = 0; i < sizeof(buffer); i++) {
+      if (buffer[i] != 0) return false;
+    }
+    return true;
+  }
+
+  uint8_t buffer[TEST_BUFFER_SIZE];
+  uint8_t shadow[TEST_BUFFER_SIZE];
+  int16_t historyBuffer[TEST_HISTORY_SIZE];
+  uint16_t minIndexBuffer[TEST_HISTORY_SIZE];
+  uint16_t maxIndexBuffer[TEST_HISTORY_SIZE];
+  SensorDataTrend::Bucket trendBuffer[SensorDataTrend::TIER_COUNT * TEST_TREND_SIZE];
+
+  SSD1306 display;
+  SensorDataHistory history;
+  SensorDataTrend trend;
+  Model model;
+  View view;
+};
+
+TEST_F(ViewTest, RendersEveryMode) {
+  for (int i = 0; i < 50; i++) {
+    push(2000 + (i % 7) * 15);
+  }
+  for (int mode = 0; mode < View::VIEW_MODE_COUNT; mode++) {
+    view.setViewMode(static_cast<View::ViewMode>(mode));
+    renderAndFlush();
+    EXPECT_FALSE(isBlank()) << "mode " << mode;
+    EXPECT_EQ(0, memcmp(buffer, shadow, sizeof(buffer))) << "mode " << mode;
+  }
+}
+
+TEST_F(ViewTest, SkipsFrameWhenNothingChanged) {
+  push(2150);
+  renderAndFlush();
+
+  Wire.resetCounters();
+  renderAndFlush();
+  EXPECT_EQ(0u, Wire.getTransactions());
+
+  // A new sample scrolls the chart in, so the frame changes.
+  push(2250);
+  renderAndFlush();
+  EXPECT_GT(Wire.getTransactions(), 0u);
+
+  // invalidate() forces drawing; the shadow keeps the transfer empty.
+  Wire.resetCounters();
+  view.invalidate();
+  renderAndFlush();
+  EXPECT_EQ(0u, Wire.getTransactions());
+}
+
+TEST_F(ViewTest, ScrolledChartMatchesRedraw) {
+  expectScrollMatchesRedraw(false, 31);
+}
+
+TEST_F(ViewTest, ScrolledChartMatchesRedrawWithHardwareScroll) {
+  expectScrollMatchesRedraw(true, 32);
+}
+
+// A view that skips unchanged frames against one that is invalidated before every render, over
+// random samples (below and above the display resolution), resolutions, modes and flips.
+TEST_F(ViewTest, SkippedRendersMatchAlwaysRedrawing) {
+  uint8_t referenceBuffer[TEST_BUFFER_SIZE];
+  SSD1306 reference(TEST_WIDTH, TEST_HEIGHT, referenceBuffer);
+  View referenceView(model, reference, TEST_STEP);
+  referenceView.begin();
+
+  srand(33);
+  // Kept around zero, so "-0.x" and "0.x" both come up.
+  int16_t walk = 0;
+  uint8_t resolution = 12;
+  unsigned long skipped = 0;
+  for (int i = 0; i < 3000; i++) {
+    int r = rand() % 100;
+    if (r < 45) {
+      walk += rand() % 7 - 3;
+      if (walk < -30 || walk > 30) walk /= 2;
+      push((rand() % 30 == 0) ? INVALID_TEMPERATURE_VALUE : walk, resolution);
+    } else if (r < 50) {
+      resolution = 9 + rand() % 4;
+      push(walk, resolution);
+    } else if (r < 55) {
+      View::ViewMode mode = static_cast<View::ViewMode>(rand() % View::VIEW_MODE_COUNT);
+      view.setViewMode(mode);
+      referenceView.setViewMode(mode);
+    } else if (r < 57) {
+      view.flip();
+      referenceView.flip();
+    } else if (r < 75) {
+      // Time passes without a sample; the trend tiers still close buckets on the next one.
+      delay(60000);
+    }
+
+    Wire.resetCounters();
+    ASSERT_TRUE(view.render());
+    if (!display.isBusy() && Wire.getTransactions() == 0) {
+      skipped++;
+    }
+    flush(display);
+    referenceView.invalidate();
+    ASSERT_TRUE(referenceView.render());
+    flush(reference);
+    ASSERT_EQ(0, memcmp(referenceBuffer, buffer, sizeof(buffer))) << "step " << i;
+  }
+  EXPECT_GT(skipped, 100u);
+}
+
+TEST_F(ViewTest, RenderWaitsForBusyDisplay) {
+  push(2150);
+  ASSERT_TRUE(view.render());
+  ASSERT_TRUE(display.isBusy());
+  push(2160);
+  EXPECT_FALSE(view.render());
+  while (display.update()) {
+  }
+  EXPECT_TRUE(view.render());
+}
+
+// The reading arrives snapped to the sensor step with the offset added; a lower resolution must
+// not snap it again and drop the offset.
+TEST_F(ViewTest, ReducedResolutionKeepsOffset) {
+  uint8_t fullResolution[TEST_BUFFER_SIZE];
+  view.setViewMode(View::VIEW_MODE_TEXT);
+  push(2537, 12);
+  renderAndFlush();
+  memcpy(fullResolution, buffer, sizeof(buffer));
+
+  push(2537, 9);
+  view.invalidate();
+  renderAndFlush();
+  EXPECT_EQ(0, memcmp(fullResolution, buffer, sizeof(buffer)));
+}
+
+TEST_F(ViewTest, TextModeShowsInvalidReading) {
+  view.setViewMode(View::VIEW_MODE_TEXT);
+  push(INVALID_TEMPERATURE_VALUE);
+  renderAndFlush();
+  EXPECT_FALSE(isBlank());
+}
+
+// formatCentiValue() as the sprintf() formatting it replaced.
+static void referenceCentiValue(int16_t value, char* text, size_t size) {
+  if (!IS_VALID_TEMPERATURE(value)) {
+    snprintf(text, size, "--.-");
+    return;
+  }
+  int16_t intPart = value / 100;
+  uint8_t fracPart = abs(value % 100) / 10;
+  if (value < 0 && intPart == 0) {
+    snprintf(text, size, "-0.%u", fracPart);
+  } else {
+    snprintf(text, size, "%d.%u", intPart, fracPart);
+  }
+}
+
+TEST(ViewFormatTest, FormatCentiValueMatchesPrintf) {
+  for (int32_t value = INT16_MIN; value <= INT16_MAX; value++) {
+    char expected[16];
+    char text[8];
+    referenceCentiValue(value, expected, sizeof(expected));
+    uint8_t len = View::formatCentiValue(value, text);
+    ASSERT_STREQ(expected, text) << "value " << value;
+    ASSERT_EQ(strlen(expected), len) << "value " << value;
+  }
+
+  char text[8];
+  View::formatCentiValue(-5, text);
+  EXPECT_STREQ("-0.0", text);
+  View::formatCentiValue(-99, text);
+  EXPECT_STREQ("-0.9", text);
+  View::formatCentiValue(-100, text);
+  EXPECT_STREQ("-1.0", text);
+  View::formatCentiValue(INT16_MIN + 1, text);
+  EXPECT_STREQ("-327.6", text);
+}